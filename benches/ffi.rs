@@ -0,0 +1,182 @@
+//! Benchmarks for the FFI shim layer.
+//!
+//! Run with `cargo bench --features __unstable_internals_for_benchmarks`.
+//!
+//! Calls into HexChat go through a mock vtable of stub function pointers
+//! (see `hexavalent::benchmarks::mock_plugin_vtable`), so these numbers measure
+//! hexavalent's overhead around the FFI boundary, not HexChat itself.
+
+use std::ffi::CString;
+use std::iter;
+use std::os::raw::c_char;
+use std::ptr;
+
+use criterion::{black_box, criterion_group, criterion_main, Criterion};
+
+use hexavalent::benchmarks::{self, hexchat_plugin};
+use hexavalent::event::print::{Banned, ChannelMessage};
+use hexavalent::event::server::Privmsg;
+use hexavalent::{Plugin, PluginHandle};
+
+#[derive(Default)]
+struct BenchPlugin;
+
+impl Plugin for BenchPlugin {
+    fn init(&self, _ph: PluginHandle<'_, Self>) {}
+}
+
+/// Leaks a mock vtable, so that pointers into it stay valid for the whole run.
+fn leaked_vtable() -> *mut hexchat_plugin {
+    Box::into_raw(Box::new(benchmarks::mock_plugin_vtable()))
+}
+
+/// An owned `word`-style array: index 0 reserved, then `words`, then a null terminator.
+struct WordArray {
+    _words: Vec<CString>,
+    array: Vec<*mut c_char>,
+}
+
+impl WordArray {
+    fn new(words: impl IntoIterator<Item = String>) -> Self {
+        let words: Vec<_> = words
+            .into_iter()
+            .map(|w| CString::new(w).unwrap())
+            .collect();
+        let mut array = Vec::with_capacity(words.len() + 2);
+        array.push(ptr::null_mut());
+        array.extend(words.iter().map(|w| w.as_ptr() as *mut c_char));
+        array.push(ptr::null_mut());
+        Self {
+            _words: words,
+            array,
+        }
+    }
+
+    fn as_word(&mut self) -> *mut *mut c_char {
+        self.array.as_mut_ptr()
+    }
+}
+
+fn bench_into_cstr(c: &mut Criterion) {
+    let terminated = "PRIVMSG #channel :hello there\0";
+    let unterminated = "PRIVMSG #channel :hello there";
+    // long enough to overflow the thread-local scratch buffers, forcing the heap path
+    let long = "x".repeat(8192);
+
+    c.bench_function("into_cstr/terminated", |b| {
+        b.iter(|| benchmarks::with_cstr(black_box(terminated), |s| s.to_bytes().len()))
+    });
+    c.bench_function("into_cstr/unterminated", |b| {
+        b.iter(|| benchmarks::with_cstr(black_box(unterminated), |s| s.to_bytes().len()))
+    });
+    c.bench_function("into_cstr/long", |b| {
+        b.iter(|| benchmarks::with_cstr(black_box(long.as_str()), |s| s.to_bytes().len()))
+    });
+}
+
+fn bench_word_to_iter(c: &mut Criterion) {
+    let mut words = WordArray::new((0..16).map(|i| format!("word{}", i)));
+    let word = words.as_word();
+
+    c.bench_function("word_to_iter/traverse_16", |b| {
+        b.iter(|| {
+            // Safety: word is a valid word-style array for the duration of the call
+            let words = unsafe { benchmarks::word_to_iter(black_box(&word)) };
+            words.map(|w| w.to_bytes().len()).sum::<usize>()
+        })
+    });
+}
+
+fn bench_args_from_words(c: &mut Criterion) {
+    // HexChat always passes 32 entries, most of them empty
+    let mut words = WordArray::new((0..32).map(|i| {
+        if i < 4 {
+            format!("field{}", i)
+        } else {
+            String::new()
+        }
+    }));
+    let word = words.as_word();
+
+    c.bench_function("args_from_words/1_field", |b| {
+        b.iter(|| {
+            // Safety: word is a valid word-style array for the duration of the call
+            let words = unsafe { benchmarks::word_to_iter(black_box(&word)) };
+            benchmarks::event_args_from_words(Banned, words, iter::empty())
+        })
+    });
+    c.bench_function("args_from_words/4_fields", |b| {
+        b.iter(|| {
+            // Safety: word is a valid word-style array for the duration of the call
+            let words = unsafe { benchmarks::word_to_iter(black_box(&word)) };
+            benchmarks::event_args_from_words(ChannelMessage, words, iter::empty())
+        })
+    });
+
+    // an event with an eol field, where the tail is the longest string in the event
+    let line = ":alice!alice@host PRIVMSG #channel :hello there, this is a typical message body";
+    let tokens: Vec<&str> = line.split(' ').collect();
+    let mut words =
+        WordArray::new((0..32).map(|i| tokens.get(i).copied().unwrap_or("").to_owned()));
+    let mut words_eol = WordArray::new((0..32).map(|i| {
+        if i < tokens.len() {
+            tokens[i..].join(" ")
+        } else {
+            String::new()
+        }
+    }));
+    let word = words.as_word();
+    let word_eol = words_eol.as_word();
+
+    c.bench_function("args_from_words/eol_field", |b| {
+        b.iter(|| {
+            // Safety: word and word_eol are valid word-style arrays for the duration of the call
+            let words = unsafe { benchmarks::word_to_iter(black_box(&word)) };
+            let words_eol = unsafe { benchmarks::word_to_iter(black_box(&word_eol)) };
+            benchmarks::event_args_from_words(Privmsg, words, words_eol)
+        })
+    });
+}
+
+fn bench_list_elem(c: &mut Criterion) {
+    let handle = leaked_vtable();
+    // the mock vtable never dereferences the list pointer
+    let list = ptr::NonNull::dangling().as_ptr();
+    // Safety: handle points to a valid (mock) vtable; the mock list accepts any field name
+    let elem = unsafe { benchmarks::list_elem(&handle, &list) };
+
+    c.bench_function("list_elem/string", |b| {
+        b.iter(|| benchmarks::list_elem_string(&elem, black_box("channel\0")))
+    });
+    c.bench_function("list_elem/int", |b| {
+        b.iter(|| benchmarks::list_elem_int(&elem, black_box("id\0")))
+    });
+}
+
+fn bench_dispatch(c: &mut Criterion) {
+    // Safety: the leaked vtable is valid for the rest of the run
+    unsafe { benchmarks::init_plugin::<BenchPlugin>(leaked_vtable()) };
+
+    c.bench_function("dispatch/catch_and_log_unwind", |b| {
+        b.iter(|| benchmarks::catch_and_log_unwind("bench", || black_box(1)).unwrap())
+    });
+    c.bench_function("dispatch/hook_callback", |b| {
+        // what every hook callback trampoline does around the user's callback
+        b.iter(|| {
+            benchmarks::catch_and_log_unwind("bench", || {
+                benchmarks::with_plugin_state::<BenchPlugin, _>(|_plugin, _ph| black_box(1))
+            })
+            .unwrap()
+        })
+    });
+}
+
+criterion_group!(
+    benches,
+    bench_into_cstr,
+    bench_word_to_iter,
+    bench_args_from_words,
+    bench_list_elem,
+    bench_dispatch,
+);
+criterion_main!(benches);
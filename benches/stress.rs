@@ -0,0 +1,197 @@
+//! Throughput stress suite against the mock HexChat harness.
+//!
+//! Run with `cargo bench --bench stress --features __unstable_internals_for_benchmarks`.
+//!
+//! Loads a plugin through the real `hexchat_plugin_init` path, then replays a synthetic
+//! message flood through the captured hook table at maximum rate (see
+//! `hexavalent::benchmarks::mock_harness_vtable`), reporting events/sec and heap
+//! allocations/event for the hottest dispatch paths.
+
+use std::alloc::{GlobalAlloc, Layout, System};
+use std::cell::Cell;
+use std::sync::atomic::{AtomicUsize, Ordering};
+use std::time::Instant;
+
+use hexavalent::benchmarks::{self, WordArray};
+use hexavalent::event::print::ChannelMessage;
+use hexavalent::event::server::Privmsg;
+use hexavalent::event::Event;
+use hexavalent::hook::{Eat, Priority};
+use hexavalent::list::Users;
+use hexavalent::{Plugin, PluginHandle};
+
+/// Counts heap allocations, so the suite can report allocations/event.
+struct CountingAllocator;
+
+static ALLOCATIONS: AtomicUsize = AtomicUsize::new(0);
+
+// Safety: defers to the system allocator
+unsafe impl GlobalAlloc for CountingAllocator {
+    unsafe fn alloc(&self, layout: Layout) -> *mut u8 {
+        ALLOCATIONS.fetch_add(1, Ordering::Relaxed);
+        System.alloc(layout)
+    }
+
+    unsafe fn dealloc(&self, ptr: *mut u8, layout: Layout) {
+        System.dealloc(ptr, layout)
+    }
+}
+
+#[global_allocator]
+static ALLOCATOR: CountingAllocator = CountingAllocator;
+
+#[derive(Default)]
+struct StressPlugin {
+    print_events: Cell<usize>,
+    server_events: Cell<usize>,
+}
+
+fn channel_message_cb(
+    plugin: &StressPlugin,
+    _ph: PluginHandle<'_, StressPlugin>,
+    _args: <ChannelMessage as Event<'_>>::Args,
+) -> Eat {
+    plugin.print_events.set(plugin.print_events.get() + 1);
+    Eat::None
+}
+
+fn privmsg_cb(
+    plugin: &StressPlugin,
+    _ph: PluginHandle<'_, StressPlugin>,
+    _args: <Privmsg as Event<'_>>::Args,
+) -> Eat {
+    plugin.server_events.set(plugin.server_events.get() + 1);
+    Eat::None
+}
+
+impl Plugin for StressPlugin {
+    fn init(&self, ph: PluginHandle<'_, Self>) {
+        ph.hook_print(ChannelMessage, Priority::Normal, channel_message_cb);
+        ph.hook_server(Privmsg, Priority::Normal, privmsg_cb);
+    }
+}
+
+/// The number of events replayed per flood.
+const EVENTS: usize = 1_000_000;
+
+/// The number of distinct prepared lines cycled through during a flood,
+/// so that the replay loop does not hit a single hot cache line unrealistically.
+const POOL_SIZE: usize = 256;
+
+fn pad_to_32(words: impl IntoIterator<Item = String>) -> WordArray {
+    let words: Vec<_> = words.into_iter().collect();
+    let padding = 32 - words.len();
+    WordArray::new(words.into_iter().chain((0..padding).map(|_| String::new())))
+}
+
+fn report(name: &str, events: usize, secs: f64, allocs: usize) {
+    println!(
+        "{:<24} {:>9} events in {:.3}s  ({:>11.0} events/sec, {:.3} allocs/event)",
+        name,
+        events,
+        secs,
+        events as f64 / secs,
+        allocs as f64 / events as f64,
+    );
+}
+
+fn flood(name: &str, mut replay: impl FnMut()) {
+    // warmup, so that one-time allocations (scratch buffers etc.) are not counted
+    for _ in 0..1000 {
+        replay();
+    }
+
+    let allocs_before = ALLOCATIONS.load(Ordering::Relaxed);
+    let start = Instant::now();
+    for _ in 0..EVENTS {
+        replay();
+    }
+    let secs = start.elapsed().as_secs_f64();
+    let allocs = ALLOCATIONS.load(Ordering::Relaxed) - allocs_before;
+
+    report(name, EVENTS, secs, allocs);
+}
+
+fn main() {
+    let vtable = Box::into_raw(Box::new(benchmarks::mock_harness_vtable()));
+    // Safety: the leaked vtable is valid for the rest of the run
+    unsafe { benchmarks::init_plugin::<StressPlugin>(vtable) };
+
+    // `ChannelMessage` flood: [nick, text, mode, identified]
+    let mut print_pool: Vec<_> = (0..POOL_SIZE)
+        .map(|i| {
+            pad_to_32(vec![
+                format!("nick{}", i),
+                format!(
+                    "hello from nick{}, just flooding the channel at full rate",
+                    i
+                ),
+                "@".to_owned(),
+                String::new(),
+            ])
+        })
+        .collect();
+    let mut i = 0;
+    flood("print/ChannelMessage", || {
+        let line = &mut print_pool[i % POOL_SIZE];
+        i += 1;
+        // Safety: line is a valid word-style array for the duration of the call
+        let invoked = unsafe { benchmarks::replay_print_event("Channel Message", line.as_word()) };
+        assert_eq!(invoked, 1);
+    });
+
+    // `PRIVMSG` flood: word is the tokenized line, word_eol the tails
+    let words: Vec<_> = (0..POOL_SIZE)
+        .map(|i| {
+            vec![
+                format!(":nick{0}!user{0}@host{0}", i),
+                "PRIVMSG".to_owned(),
+                "#channel".to_owned(),
+                format!(
+                    ":hello from nick{}, just flooding the channel at full rate",
+                    i
+                ),
+            ]
+        })
+        .collect();
+    let mut server_pool: Vec<_> = words
+        .iter()
+        .map(|words| {
+            let word = pad_to_32(words.clone());
+            let word_eol = pad_to_32((0..words.len()).map(|n| words[n..].join(" ")));
+            (word, word_eol)
+        })
+        .collect();
+    let mut i = 0;
+    flood("server/PRIVMSG", || {
+        let (word, word_eol) = &mut server_pool[i % POOL_SIZE];
+        i += 1;
+        // Safety: word and word_eol are valid word-style arrays for the duration of the call
+        let invoked = unsafe {
+            benchmarks::replay_server_event("PRIVMSG", false, word.as_word(), word_eol.as_word())
+        };
+        assert_eq!(invoked, 1);
+    });
+
+    // `get_list` against the synthetic users list served by the harness
+    let lists = 10_000;
+    let allocs_before = ALLOCATIONS.load(Ordering::Relaxed);
+    let start = Instant::now();
+    let mut users = 0;
+    for _ in 0..lists {
+        users += benchmarks::with_plugin_state::<StressPlugin, _>(|_plugin, ph| {
+            ph.get_list(Users).unwrap().len()
+        });
+    }
+    let secs = start.elapsed().as_secs_f64();
+    let allocs = ALLOCATIONS.load(Ordering::Relaxed) - allocs_before;
+    report("list/users", users, secs, allocs);
+
+    // sanity-check that the floods went through the real hook dispatch path
+    let (print_events, server_events) =
+        benchmarks::with_plugin_state::<StressPlugin, _>(|plugin, _ph| {
+            (plugin.print_events.get(), plugin.server_events.get())
+        });
+    assert_eq!(print_events, EVENTS + 1000);
+    assert_eq!(server_events, EVENTS + 1000);
+}
@@ -0,0 +1,317 @@
+//! Background job offload.
+
+use std::any::Any;
+use std::cell::{Cell, RefCell};
+use std::collections::HashMap;
+use std::fmt;
+use std::panic::{catch_unwind, AssertUnwindSafe};
+use std::sync::mpsc::{channel, Receiver, Sender};
+use std::sync::{Arc, Mutex};
+use std::thread;
+use std::time::Duration;
+
+use crate::hook::{HookHandle, Timer};
+use crate::plugin::PluginHandle;
+
+/// A job sent to a worker thread.
+type Job = Box<dyn FnOnce() + Send>;
+
+/// A job's result (or panic payload), sent back to the HexChat thread.
+type Completion = (u64, thread::Result<Box<dyn Any + Send>>);
+
+/// Runs CPU-heavy jobs on worker threads, marshalling results back to the HexChat thread.
+///
+/// The plugin state guard in this crate (correctly) panics if the plugin is touched
+/// from any thread but HexChat's, so CPU-heavy work — searching hundreds of MB of logs, say —
+/// otherwise has to run on the UI thread and block it.
+/// `BackgroundJobs` is the sanctioned escape hatch:
+/// [`spawn_blocking`](BackgroundJobs::spawn_blocking) runs a job on a crate-managed worker pool,
+/// then runs its completion callback back on the HexChat thread with full [`PluginHandle`] access,
+/// so the plugin's threading invariant is never violated.
+///
+/// Results travel through a channel drained by an internally-registered timer,
+/// so no locks are held while user code runs.
+///
+/// To use it, store a `BackgroundJobs` in your plugin, implement `AsRef<BackgroundJobs<Self>>`,
+/// and call [`PluginHandle::hook_background_jobs`] in [`Plugin::init`](crate::Plugin::init).
+/// See [`PluginHandle::hook_background_jobs`] for an example.
+pub struct BackgroundJobs<P> {
+    /// Sends jobs to the worker pool. `None` until the first job spawns the workers.
+    jobs: RefCell<Option<Sender<Job>>>,
+    /// The worker-thread half of the completion channel, cloned into each job.
+    completion_tx: Sender<Completion>,
+    /// The HexChat-thread half of the completion channel.
+    completion_rx: Receiver<Completion>,
+    /// Completion callbacks awaiting their job's result, by job id.
+    #[allow(clippy::type_complexity)]
+    pending: RefCell<HashMap<u64, Box<dyn FnOnce(&P, PluginHandle<'_, P>, Box<dyn Any + Send>)>>>,
+    /// The id assigned to the next spawned job.
+    next_id: Cell<u64>,
+    /// Number of worker threads to spawn.
+    workers: usize,
+}
+
+impl<P> fmt::Debug for BackgroundJobs<P> {
+    fn fmt(&self, f: &mut fmt::Formatter<'_>) -> fmt::Result {
+        f.debug_struct("BackgroundJobs")
+            .field("pending", &self.pending.borrow().len())
+            .field("workers", &self.workers)
+            .finish()
+    }
+}
+
+impl<P> Default for BackgroundJobs<P> {
+    fn default() -> Self {
+        Self::new()
+    }
+}
+
+impl<P> BackgroundJobs<P> {
+    /// Creates a new `BackgroundJobs` pool with one worker per available CPU.
+    ///
+    /// Worker threads are not spawned until the first job is.
+    pub fn new() -> Self {
+        let workers = thread::available_parallelism().map_or(1, |n| n.get());
+        Self::with_workers(workers)
+    }
+
+    /// Creates a new `BackgroundJobs` pool with `workers` worker threads.
+    ///
+    /// Worker threads are not spawned until the first job is.
+    ///
+    /// # Panics
+    ///
+    /// If `workers` is 0.
+    pub fn with_workers(workers: usize) -> Self {
+        assert!(workers > 0, "Background job pool must have a worker");
+        let (completion_tx, completion_rx) = channel();
+        Self {
+            jobs: RefCell::new(None),
+            completion_tx,
+            completion_rx,
+            pending: RefCell::new(HashMap::new()),
+            next_id: Cell::new(0),
+            workers,
+        }
+    }
+
+    /// Runs `job` on a worker thread, then `on_done` with its result on the HexChat thread.
+    ///
+    /// `job` must not touch plugin state (doing so panics, by design);
+    /// `on_done` runs as if from a hook callback and can do anything a hook can.
+    /// Completions are delivered by the timer registered with [`PluginHandle::hook_background_jobs`],
+    /// so `on_done` runs no sooner than the next tick.
+    ///
+    /// If `job` panics, the panic is re-raised on the HexChat thread
+    /// (where it is caught and logged like any hook callback panic), and `on_done` never runs.
+    ///
+    /// Jobs in flight when the plugin is unloaded are left to finish on their worker,
+    /// but their results are discarded and their `on_done` callbacks never run.
+    pub fn spawn_blocking<T, J, F>(&self, job: J, on_done: F)
+    where
+        T: Send + 'static,
+        J: FnOnce() -> T + Send + 'static,
+        F: FnOnce(&P, PluginHandle<'_, P>, T) + 'static,
+    {
+        let id = self.next_id.get();
+        self.next_id.set(id + 1);
+
+        self.pending.borrow_mut().insert(
+            id,
+            Box::new(move |plugin, ph, result| {
+                let result = result
+                    .downcast::<T>()
+                    .unwrap_or_else(|_| panic!("Background job result is an unexpected type"));
+                on_done(plugin, ph, *result)
+            }),
+        );
+
+        let completions = self.completion_tx.clone();
+        let job = Box::new(move || {
+            let result = catch_unwind(AssertUnwindSafe(job))
+                .map(|result| Box::new(result) as Box<dyn Any + Send>);
+            // if the plugin was unloaded, there is nobody left to receive the result
+            let _ = completions.send((id, result));
+        });
+
+        self.job_sender()
+            .send(job)
+            .unwrap_or_else(|e| panic!("Background worker pool shut down: {}", e));
+    }
+
+    /// Returns the job sender, spawning the worker pool on first use.
+    fn job_sender(&self) -> Sender<Job> {
+        let mut jobs = self.jobs.borrow_mut();
+        if let Some(sender) = &*jobs {
+            return sender.clone();
+        }
+
+        let (sender, receiver) = channel::<Job>();
+        let receiver = Arc::new(Mutex::new(receiver));
+
+        for _ in 0..self.workers {
+            let receiver = Arc::clone(&receiver);
+            thread::spawn(move || loop {
+                let job = {
+                    let receiver = receiver
+                        .lock()
+                        .unwrap_or_else(|e| panic!("Background job lock poisoned: {}", e));
+                    receiver.recv()
+                };
+                match job {
+                    Ok(job) => job(),
+                    // the pool was dropped (plugin unloaded), no more jobs are coming
+                    Err(_) => return,
+                }
+            });
+        }
+
+        *jobs = Some(sender.clone());
+        sender
+    }
+
+    /// Runs the completion callback of every finished job.
+    fn drain(&self, plugin: &P, ph: PluginHandle<'_, P>) {
+        while let Ok((id, result)) = self.completion_rx.try_recv() {
+            let on_done = self
+                .pending
+                .borrow_mut()
+                .remove(&id)
+                .unwrap_or_else(|| panic!("Background job {} has no completion callback", id));
+
+            match result {
+                Ok(result) => on_done(plugin, ph, result),
+                // re-raise the job's panic here, where it is caught and logged like any hook panic
+                Err(payload) => std::panic::resume_unwind(payload),
+            }
+        }
+    }
+}
+
+/// [Background Jobs](crate::background::BackgroundJobs)
+///
+/// Allows your plugin to offload CPU-heavy work to worker threads.
+impl<'ph, P: 'static + AsRef<BackgroundJobs<P>>> PluginHandle<'ph, P> {
+    /// Registers the HexChat timer delivering your plugin's [`BackgroundJobs`] results.
+    ///
+    /// Every `resolution`, the results of finished jobs are handed to their completion callbacks.
+    ///
+    /// Call this once from [`Plugin::init`](crate::Plugin::init).
+    ///
+    /// Returns a [`HookHandle`](crate::hook::HookHandle) which can be passed to
+    /// [`PluginHandle::unhook`](crate::PluginHandle::unhook) to stop delivering results entirely.
+    ///
+    /// # Examples
+    ///
+    /// ```rust
+    /// use std::time::Duration;
+    /// use hexavalent::{Plugin, PluginHandle};
+    /// use hexavalent::background::BackgroundJobs;
+    /// use hexavalent::hook::{Eat, Priority};
+    ///
+    /// #[derive(Default)]
+    /// struct MyPlugin {
+    ///     jobs: BackgroundJobs<MyPlugin>,
+    /// }
+    ///
+    /// impl AsRef<BackgroundJobs<MyPlugin>> for MyPlugin {
+    ///     fn as_ref(&self) -> &BackgroundJobs<MyPlugin> {
+    ///         &self.jobs
+    ///     }
+    /// }
+    ///
+    /// fn search_logs(haystack: String, needle: String) -> usize {
+    ///     haystack.matches(&needle).count()
+    /// }
+    ///
+    /// impl Plugin for MyPlugin {
+    ///     fn init(&self, ph: PluginHandle<'_, Self>) {
+    ///         ph.hook_background_jobs(Duration::from_millis(100));
+    ///
+    ///         ph.hook_command_with(
+    ///             "searchlogs\0",
+    ///             "Usage: SEARCHLOGS <text>, searches the logs off-thread\0",
+    ///             Priority::Normal,
+    ///             |plugin, ph, words| {
+    ///                 let needle = words[1].to_string();
+    ///                 let haystack = String::new(); // read the log files here
+    ///                 plugin.jobs.spawn_blocking(
+    ///                     move || search_logs(haystack, needle),
+    ///                     |plugin, ph, count| {
+    ///                         ph.print(&format!("Found {} matches.\0", count));
+    ///                     },
+    ///                 );
+    ///                 Eat::All
+    ///             },
+    ///         );
+    ///     }
+    /// }
+    /// ```
+    pub fn hook_background_jobs(self, resolution: Duration) -> HookHandle {
+        self.hook_timer(resolution, |plugin, ph| {
+            plugin.as_ref().drain(plugin, ph);
+            Timer::Continue
+        })
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use std::ptr;
+    use std::time::Instant;
+
+    use super::*;
+
+    /// A `PluginHandle` for callbacks which never touch HexChat.
+    ///
+    /// Safety: the returned handle must not be used to call any HexChat function.
+    unsafe fn dangling_plugin_handle() -> PluginHandle<'static, ()> {
+        PluginHandle::new(ptr::null_mut())
+    }
+
+    fn drain_until<P>(jobs: &BackgroundJobs<P>, plugin: &P, ph: PluginHandle<'_, P>) {
+        let deadline = Instant::now() + Duration::from_secs(10);
+        while !jobs.pending.borrow().is_empty() {
+            assert!(Instant::now() < deadline, "Background job never completed");
+            jobs.drain(plugin, ph);
+            thread::yield_now();
+        }
+    }
+
+    #[test]
+    fn results_are_marshalled_back() {
+        // Safety: the handle is never used to call HexChat
+        let ph = unsafe { dangling_plugin_handle() };
+        let jobs = BackgroundJobs::<()>::with_workers(2);
+        let results = std::rc::Rc::new(RefCell::new(Vec::new()));
+
+        for i in 0..4_u32 {
+            let results = std::rc::Rc::clone(&results);
+            jobs.spawn_blocking(
+                move || (i, thread::current().id()),
+                move |_plugin, _ph, (i, worker)| {
+                    assert_ne!(worker, thread::current().id());
+                    results.borrow_mut().push(i);
+                },
+            );
+        }
+
+        drain_until(&jobs, &(), ph);
+
+        let mut results = results.borrow_mut();
+        results.sort_unstable();
+        assert_eq!(*results, [0, 1, 2, 3]);
+    }
+
+    #[test]
+    #[should_panic]
+    fn job_panics_resurface_on_drain() {
+        // Safety: the handle is never used to call HexChat
+        let ph = unsafe { dangling_plugin_handle() };
+        let jobs = BackgroundJobs::<()>::with_workers(1);
+
+        jobs.spawn_blocking(|| panic!("job failed"), |_plugin, _ph, ()| {});
+
+        drain_until(&jobs, &(), ph);
+    }
+}
@@ -0,0 +1,997 @@
+//! This module exists solely to provide exports for the benchmark suite to use.
+//!
+//! DO NOT IMPORT OR USE ANYTHING FROM THIS MODULE
+
+use std::cell::RefCell;
+use std::ffi::{CStr, CString};
+use std::mem;
+use std::os::raw::{c_char, c_int, c_void};
+use std::panic::UnwindSafe;
+use std::ptr::{self, NonNull};
+use std::sync::atomic::{AtomicUsize, Ordering};
+
+use libc::time_t;
+
+use crate::event::Event;
+use crate::ffi::{hexchat_context, hexchat_event_attrs, hexchat_hook, StrExt};
+use crate::plugin::{Plugin, PluginHandle};
+use crate::state;
+
+/// UNSTABLE: do not use this type.
+///
+/// Used by the benchmark suite.
+#[doc(hidden)]
+pub use crate::ffi::{hexchat_list, hexchat_plugin, ListElem};
+
+/// UNSTABLE: do not call this function.
+///
+/// Runs `f` with the C-style string conversion of `s`, exercising `into_cstr`.
+#[doc(hidden)]
+pub fn with_cstr<R>(s: &str, f: impl FnOnce(&CStr) -> R) -> R {
+    f(s.into_cstr().as_ref())
+}
+
+/// UNSTABLE: do not call this function.
+///
+/// Converts `word` or `word_eol` to an iterator over `&CStr`.
+///
+/// # Safety
+///
+/// `word` must be a `word` or `word_eol` pointer as passed by HexChat
+/// (that is, a null-terminated array whose first index is reserved),
+/// valid for the entire lifetime `'a`.
+#[doc(hidden)]
+#[allow(clippy::trivially_copy_pass_by_ref)]
+pub unsafe fn word_to_iter<'a>(word: &'a *mut *mut c_char) -> impl Iterator<Item = &'a CStr> {
+    crate::ffi::word_to_iter(word)
+}
+
+/// UNSTABLE: do not call this function.
+///
+/// Decodes an event's args from `word`/`word_eol` iterators, exercising `args_from_words`.
+#[doc(hidden)]
+pub fn event_args_from_words<'a, E: Event<'a>>(
+    _event: E,
+    word: impl Iterator<Item = &'a CStr>,
+    word_eol: impl Iterator<Item = &'a CStr>,
+) -> <E as Event<'a>>::Args {
+    E::args_from_words(word, word_eol)
+}
+
+/// UNSTABLE: do not call this function.
+///
+/// Creates a `ListElem` from a native list handle.
+///
+/// # Safety
+///
+/// `handle` must point to a valid instance of `hexchat_plugin`.
+/// `list` must point to a list which is valid for the entire lifetime `'a`
+/// and whose current elem contains every field that is extracted from the `ListElem`.
+#[doc(hidden)]
+pub unsafe fn list_elem<'a>(
+    handle: &'a *mut hexchat_plugin,
+    list: &'a *mut hexchat_list,
+) -> ListElem<'a> {
+    ListElem::new(handle, list)
+}
+
+/// UNSTABLE: do not call this function.
+///
+/// Extracts a string field from a `ListElem`.
+#[doc(hidden)]
+pub fn list_elem_string<'a>(elem: &ListElem<'a>, null_terminated_name: &str) -> Option<&'a str> {
+    elem.string(null_terminated_name)
+}
+
+/// UNSTABLE: do not call this function.
+///
+/// Extracts an int field from a `ListElem`.
+#[doc(hidden)]
+pub fn list_elem_int(elem: &ListElem<'_>, null_terminated_name: &str) -> i32 {
+    elem.int(null_terminated_name)
+}
+
+/// UNSTABLE: do not call this function.
+///
+/// Runs `f` under the panic handling every hook callback trampoline goes through.
+#[doc(hidden)]
+pub fn catch_and_log_unwind<R>(
+    ctxt_msg: &'static str,
+    f: impl FnOnce() -> R + UnwindSafe,
+) -> Result<R, ()> {
+    state::catch_and_log_unwind(ctxt_msg, f)
+}
+
+/// UNSTABLE: do not call this function.
+///
+/// Runs `f` with the current plugin state, as every hook callback trampoline does.
+///
+/// The plugin must have been initialized with
+/// [`internal::hexchat_plugin_init`](crate::internal::hexchat_plugin_init).
+#[doc(hidden)]
+pub fn with_plugin_state<P: 'static, R>(f: impl FnOnce(&P, PluginHandle<'_, P>) -> R) -> R {
+    state::with_plugin_state(f)
+}
+
+/// UNSTABLE: do not call this function.
+///
+/// Initializes the global plugin state with a `P`, as HexChat does when loading the plugin.
+///
+/// # Safety
+///
+/// `plugin_handle` must point to a valid `hexchat_plugin` which outlives the plugin state
+/// (for benchmarks, one leaked from [`mock_plugin_vtable`] works).
+#[doc(hidden)]
+pub unsafe fn init_plugin<P: Plugin>(plugin_handle: *mut hexchat_plugin) {
+    assert_eq!(state::hexchat_plugin_init::<P>(plugin_handle), 1);
+}
+
+/// The number of mock vtable calls recorded so far, across all entry points.
+static FFI_CALLS: AtomicUsize = AtomicUsize::new(0);
+
+fn record_ffi_call() {
+    FFI_CALLS.fetch_add(1, Ordering::Relaxed);
+}
+
+/// UNSTABLE: do not call this function.
+///
+/// The number of calls made through [`mock_plugin_vtable`] function pointers so far,
+/// to verify that a benchmark hit (or avoided) the FFI boundary as expected.
+#[doc(hidden)]
+pub fn ffi_call_count() -> usize {
+    FFI_CALLS.load(Ordering::Relaxed)
+}
+
+/// String returned by mock vtable entries which produce a string.
+const MOCK_STRING: &[u8] = b"mock\0";
+
+/// UNSTABLE: do not call this function.
+///
+/// Creates a `hexchat_plugin` vtable of stub function pointers which record each call
+/// (see [`ffi_call_count`]) and return fixed values, so that benchmarks can measure
+/// hexavalent's overhead without a running HexChat.
+///
+/// Entries which register hooks return a dangling (non-null) hook pointer;
+/// `hexchat_list_str` and `hexchat_get_info` return `"mock"`; `hexchat_list_int` returns `42`;
+/// `hexchat_event_attrs_create`/`free` really allocate and free.
+/// The variadic entries (`hexchat_printf` and friends) ignore their variadic arguments.
+#[doc(hidden)]
+pub fn mock_plugin_vtable() -> hexchat_plugin {
+    unsafe extern "C" fn hook_command(
+        _ph: *mut hexchat_plugin,
+        _name: *const c_char,
+        _pri: c_int,
+        _callback: unsafe extern "C" fn(*mut *mut c_char, *mut *mut c_char, *mut c_void) -> c_int,
+        _help_text: *const c_char,
+        _userdata: *mut c_void,
+    ) -> *mut hexchat_hook {
+        record_ffi_call();
+        NonNull::dangling().as_ptr()
+    }
+
+    unsafe extern "C" fn hook_server(
+        _ph: *mut hexchat_plugin,
+        _name: *const c_char,
+        _pri: c_int,
+        _callback: unsafe extern "C" fn(*mut *mut c_char, *mut *mut c_char, *mut c_void) -> c_int,
+        _userdata: *mut c_void,
+    ) -> *mut hexchat_hook {
+        record_ffi_call();
+        NonNull::dangling().as_ptr()
+    }
+
+    unsafe extern "C" fn hook_print(
+        _ph: *mut hexchat_plugin,
+        _name: *const c_char,
+        _pri: c_int,
+        _callback: unsafe extern "C" fn(*mut *mut c_char, *mut c_void) -> c_int,
+        _userdata: *mut c_void,
+    ) -> *mut hexchat_hook {
+        record_ffi_call();
+        NonNull::dangling().as_ptr()
+    }
+
+    unsafe extern "C" fn hook_timer(
+        _ph: *mut hexchat_plugin,
+        _timeout: c_int,
+        _callback: unsafe extern "C" fn(*mut c_void) -> c_int,
+        _userdata: *mut c_void,
+    ) -> *mut hexchat_hook {
+        record_ffi_call();
+        NonNull::dangling().as_ptr()
+    }
+
+    unsafe extern "C" fn hook_fd(
+        _ph: *mut hexchat_plugin,
+        _fd: c_int,
+        _flags: c_int,
+        _callback: unsafe extern "C" fn(c_int, c_int, *mut c_void) -> c_int,
+        _userdata: *mut c_void,
+    ) -> *mut hexchat_hook {
+        record_ffi_call();
+        NonNull::dangling().as_ptr()
+    }
+
+    unsafe extern "C" fn unhook(_ph: *mut hexchat_plugin, _hook: *mut hexchat_hook) -> *mut c_void {
+        record_ffi_call();
+        ptr::null_mut()
+    }
+
+    unsafe extern "C" fn print(_ph: *mut hexchat_plugin, _text: *const c_char) {
+        record_ffi_call();
+    }
+
+    unsafe extern "C" fn command(_ph: *mut hexchat_plugin, _command: *const c_char) {
+        record_ffi_call();
+    }
+
+    unsafe extern "C" fn nickcmp(
+        _ph: *mut hexchat_plugin,
+        _s1: *const c_char,
+        _s2: *const c_char,
+    ) -> c_int {
+        record_ffi_call();
+        0
+    }
+
+    unsafe extern "C" fn set_context(
+        _ph: *mut hexchat_plugin,
+        _ctx: *mut hexchat_context,
+    ) -> c_int {
+        record_ffi_call();
+        1
+    }
+
+    unsafe extern "C" fn find_context(
+        _ph: *mut hexchat_plugin,
+        _servname: *const c_char,
+        _channel: *const c_char,
+    ) -> *mut hexchat_context {
+        record_ffi_call();
+        NonNull::dangling().as_ptr()
+    }
+
+    unsafe extern "C" fn get_context(_ph: *mut hexchat_plugin) -> *mut hexchat_context {
+        record_ffi_call();
+        NonNull::dangling().as_ptr()
+    }
+
+    unsafe extern "C" fn get_info(_ph: *mut hexchat_plugin, _id: *const c_char) -> *const c_char {
+        record_ffi_call();
+        MOCK_STRING.as_ptr().cast()
+    }
+
+    unsafe extern "C" fn get_prefs(
+        _ph: *mut hexchat_plugin,
+        _name: *const c_char,
+        _string: *mut *const c_char,
+        _integer: *mut c_int,
+    ) -> c_int {
+        record_ffi_call();
+        0
+    }
+
+    unsafe extern "C" fn list_get(
+        _ph: *mut hexchat_plugin,
+        _name: *const c_char,
+    ) -> *mut hexchat_list {
+        record_ffi_call();
+        NonNull::dangling().as_ptr()
+    }
+
+    unsafe extern "C" fn list_free(_ph: *mut hexchat_plugin, _xlist: *mut hexchat_list) {
+        record_ffi_call();
+    }
+
+    unsafe extern "C" fn list_fields(
+        _ph: *mut hexchat_plugin,
+        _name: *const c_char,
+    ) -> *const *const c_char {
+        record_ffi_call();
+        ptr::null()
+    }
+
+    unsafe extern "C" fn list_next(_ph: *mut hexchat_plugin, _xlist: *mut hexchat_list) -> c_int {
+        record_ffi_call();
+        0
+    }
+
+    unsafe extern "C" fn list_str(
+        _ph: *mut hexchat_plugin,
+        _xlist: *mut hexchat_list,
+        _name: *const c_char,
+    ) -> *const c_char {
+        record_ffi_call();
+        MOCK_STRING.as_ptr().cast()
+    }
+
+    unsafe extern "C" fn list_int(
+        _ph: *mut hexchat_plugin,
+        _xlist: *mut hexchat_list,
+        _name: *const c_char,
+    ) -> c_int {
+        record_ffi_call();
+        42
+    }
+
+    unsafe extern "C" fn plugingui_add(
+        _ph: *mut hexchat_plugin,
+        _filename: *const c_char,
+        _name: *const c_char,
+        _desc: *const c_char,
+        _version: *const c_char,
+        _reserved: *mut c_char,
+    ) -> *mut c_void {
+        record_ffi_call();
+        ptr::null_mut()
+    }
+
+    unsafe extern "C" fn plugingui_remove(_ph: *mut hexchat_plugin, _handle: *mut c_void) {
+        record_ffi_call();
+    }
+
+    unsafe extern "C" fn read_fd(
+        _ph: *mut hexchat_plugin,
+        _src: *mut c_void,
+        _buf: *mut c_char,
+        _len: *mut c_int,
+    ) -> c_int {
+        record_ffi_call();
+        0
+    }
+
+    unsafe extern "C" fn list_time(
+        _ph: *mut hexchat_plugin,
+        _xlist: *mut hexchat_list,
+        _name: *const c_char,
+    ) -> time_t {
+        record_ffi_call();
+        0
+    }
+
+    unsafe extern "C" fn gettext(_ph: *mut hexchat_plugin, _msgid: *const c_char) -> *mut c_char {
+        record_ffi_call();
+        MOCK_STRING.as_ptr() as *mut c_char
+    }
+
+    unsafe extern "C" fn send_modes(
+        _ph: *mut hexchat_plugin,
+        _targets: *mut *const c_char,
+        _ntargets: c_int,
+        _modes_per_line: c_int,
+        _sign: c_char,
+        _mode: c_char,
+    ) {
+        record_ffi_call();
+    }
+
+    unsafe extern "C" fn strip(
+        _ph: *mut hexchat_plugin,
+        _str: *const c_char,
+        _len: c_int,
+        _flags: c_int,
+    ) -> *mut c_char {
+        record_ffi_call();
+        ptr::null_mut()
+    }
+
+    unsafe extern "C" fn free(_ph: *mut hexchat_plugin, _ptr: *mut c_void) {
+        record_ffi_call();
+    }
+
+    unsafe extern "C" fn pluginpref_set_str(
+        _ph: *mut hexchat_plugin,
+        _var: *const c_char,
+        _value: *const c_char,
+    ) -> c_int {
+        record_ffi_call();
+        1
+    }
+
+    unsafe extern "C" fn pluginpref_get_str(
+        _ph: *mut hexchat_plugin,
+        _var: *const c_char,
+        _dest: *mut c_char,
+    ) -> c_int {
+        record_ffi_call();
+        0
+    }
+
+    unsafe extern "C" fn pluginpref_set_int(
+        _ph: *mut hexchat_plugin,
+        _var: *const c_char,
+        _value: c_int,
+    ) -> c_int {
+        record_ffi_call();
+        1
+    }
+
+    unsafe extern "C" fn pluginpref_get_int(
+        _ph: *mut hexchat_plugin,
+        _var: *const c_char,
+    ) -> c_int {
+        record_ffi_call();
+        -1
+    }
+
+    unsafe extern "C" fn pluginpref_delete(_ph: *mut hexchat_plugin, _var: *const c_char) -> c_int {
+        record_ffi_call();
+        1
+    }
+
+    unsafe extern "C" fn pluginpref_list(_ph: *mut hexchat_plugin, _dest: *mut c_char) -> c_int {
+        record_ffi_call();
+        0
+    }
+
+    unsafe extern "C" fn hook_server_attrs(
+        _ph: *mut hexchat_plugin,
+        _name: *const c_char,
+        _pri: c_int,
+        _callback: unsafe extern "C" fn(
+            *mut *mut c_char,
+            *mut *mut c_char,
+            *mut hexchat_event_attrs,
+            *mut c_void,
+        ) -> c_int,
+        _userdata: *mut c_void,
+    ) -> *mut hexchat_hook {
+        record_ffi_call();
+        NonNull::dangling().as_ptr()
+    }
+
+    unsafe extern "C" fn hook_print_attrs(
+        _ph: *mut hexchat_plugin,
+        _name: *const c_char,
+        _pri: c_int,
+        _callback: unsafe extern "C" fn(
+            *mut *mut c_char,
+            *mut hexchat_event_attrs,
+            *mut c_void,
+        ) -> c_int,
+        _userdata: *mut c_void,
+    ) -> *mut hexchat_hook {
+        record_ffi_call();
+        NonNull::dangling().as_ptr()
+    }
+
+    unsafe extern "C" fn event_attrs_create(_ph: *mut hexchat_plugin) -> *mut hexchat_event_attrs {
+        record_ffi_call();
+        // Safety: hexchat_event_attrs is a plain-old-data struct, so zeroed is a valid value
+        Box::into_raw(Box::new(mem::zeroed::<hexchat_event_attrs>()))
+    }
+
+    unsafe extern "C" fn event_attrs_free(
+        _ph: *mut hexchat_plugin,
+        attrs: *mut hexchat_event_attrs,
+    ) {
+        record_ffi_call();
+        // Safety: attrs was allocated by `event_attrs_create`
+        drop(Box::from_raw(attrs));
+    }
+
+    // variadic stubs: `extern "C" fn(..., ...)` cannot be defined on stable Rust,
+    // so transmute fixed-arity stubs, which ignore the variadic arguments entirely
+    unsafe extern "C" fn printf_fixed(_ph: *mut hexchat_plugin, _format: *const c_char) {
+        record_ffi_call();
+    }
+
+    unsafe extern "C" fn emit_print_fixed(
+        _ph: *mut hexchat_plugin,
+        _event_name: *const c_char,
+    ) -> c_int {
+        record_ffi_call();
+        1
+    }
+
+    unsafe extern "C" fn emit_print_attrs_fixed(
+        _ph: *mut hexchat_plugin,
+        _attrs: *mut hexchat_event_attrs,
+        _event_name: *const c_char,
+    ) -> c_int {
+        record_ffi_call();
+        1
+    }
+
+    hexchat_plugin {
+        hexchat_hook_command: hook_command,
+        hexchat_hook_server: hook_server,
+        hexchat_hook_print: hook_print,
+        hexchat_hook_timer: hook_timer,
+        hexchat_hook_fd: hook_fd,
+        hexchat_unhook: unhook,
+        hexchat_print: print,
+        // Safety: the stubs never read their variadic arguments,
+        // so calling them through the variadic type is ABI-compatible
+        hexchat_printf: unsafe {
+            mem::transmute(printf_fixed as unsafe extern "C" fn(*mut hexchat_plugin, *const c_char))
+        },
+        hexchat_command: command,
+        // Safety: as for hexchat_printf
+        hexchat_commandf: unsafe {
+            mem::transmute(printf_fixed as unsafe extern "C" fn(*mut hexchat_plugin, *const c_char))
+        },
+        hexchat_nickcmp: nickcmp,
+        hexchat_set_context: set_context,
+        hexchat_find_context: find_context,
+        hexchat_get_context: get_context,
+        hexchat_get_info: get_info,
+        hexchat_get_prefs: get_prefs,
+        hexchat_list_get: list_get,
+        hexchat_list_free: list_free,
+        hexchat_list_fields: list_fields,
+        hexchat_list_next: list_next,
+        hexchat_list_str: list_str,
+        hexchat_list_int: list_int,
+        hexchat_plugingui_add: plugingui_add,
+        hexchat_plugingui_remove: plugingui_remove,
+        // Safety: as for hexchat_printf
+        hexchat_emit_print: unsafe {
+            mem::transmute(
+                emit_print_fixed
+                    as unsafe extern "C" fn(*mut hexchat_plugin, *const c_char) -> c_int,
+            )
+        },
+        hexchat_read_fd: read_fd,
+        hexchat_list_time: list_time,
+        hexchat_gettext: gettext,
+        hexchat_send_modes: send_modes,
+        hexchat_strip: strip,
+        hexchat_free: free,
+        hexchat_pluginpref_set_str: pluginpref_set_str,
+        hexchat_pluginpref_get_str: pluginpref_get_str,
+        hexchat_pluginpref_set_int: pluginpref_set_int,
+        hexchat_pluginpref_get_int: pluginpref_get_int,
+        hexchat_pluginpref_delete: pluginpref_delete,
+        hexchat_pluginpref_list: pluginpref_list,
+        hexchat_hook_server_attrs: hook_server_attrs,
+        hexchat_hook_print_attrs: hook_print_attrs,
+        // Safety: as for hexchat_printf
+        hexchat_emit_print_attrs: unsafe {
+            mem::transmute(
+                emit_print_attrs_fixed
+                    as unsafe extern "C" fn(
+                        *mut hexchat_plugin,
+                        *mut hexchat_event_attrs,
+                        *const c_char,
+                    ) -> c_int,
+            )
+        },
+        hexchat_event_attrs_create: event_attrs_create,
+        hexchat_event_attrs_free: event_attrs_free,
+    }
+}
+
+/// A hook registration captured by [`mock_harness_vtable`].
+enum CapturedHook {
+    Command {
+        name: String,
+        callback: unsafe extern "C" fn(*mut *mut c_char, *mut *mut c_char, *mut c_void) -> c_int,
+        userdata: *mut c_void,
+    },
+    Server {
+        name: String,
+        callback: unsafe extern "C" fn(*mut *mut c_char, *mut *mut c_char, *mut c_void) -> c_int,
+        userdata: *mut c_void,
+    },
+    Print {
+        name: String,
+        callback: unsafe extern "C" fn(*mut *mut c_char, *mut c_void) -> c_int,
+        userdata: *mut c_void,
+    },
+    Timer {
+        callback: unsafe extern "C" fn(*mut c_void) -> c_int,
+        userdata: *mut c_void,
+    },
+    /// A hook type the harness cannot replay (fd and attrs hooks),
+    /// captured anyway so that every hook pointer stays a valid index for `unhook`.
+    Other,
+}
+
+thread_local! {
+    /// Hooks captured by [`mock_harness_vtable`],
+    /// indexed by the returned hook "pointer" value minus one.
+    static CAPTURED_HOOKS: RefCell<Vec<Option<CapturedHook>>> = RefCell::new(Vec::new());
+}
+
+fn capture_hook(hook: CapturedHook) -> *mut hexchat_hook {
+    CAPTURED_HOOKS.with(|hooks| {
+        let mut hooks = hooks.borrow_mut();
+        hooks.push(Some(hook));
+        // index + 1 so that the returned hook pointer is non-null
+        hooks.len() as *mut hexchat_hook
+    })
+}
+
+/// Finds the first live captured hook at or after `index` for which `select` returns `Some`.
+///
+/// Used by the replay functions to walk the registry one hook at a time,
+/// so that it is never borrowed while a callback runs
+/// (a callback may itself (un)register hooks) and the replay loop does not allocate
+/// (the suite reports allocations/event, which should not count the harness itself).
+fn next_captured_hook<T>(
+    index: usize,
+    select: impl Fn(&CapturedHook) -> Option<T>,
+) -> Option<(usize, T)> {
+    CAPTURED_HOOKS.with(|hooks| {
+        let hooks = hooks.borrow();
+        hooks
+            .get(index..)?
+            .iter()
+            .enumerate()
+            .find_map(|(offset, hook)| {
+                hook.as_ref()
+                    .and_then(|hook| select(hook).map(|found| (index + offset, found)))
+            })
+    })
+}
+
+/// UNSTABLE: do not call this function.
+///
+/// Replays a print event through every live hook captured for `name`
+/// by [`mock_harness_vtable`], as HexChat does when the event fires.
+/// Returns the number of hooks invoked.
+///
+/// # Safety
+///
+/// `word` must be a `word` pointer as passed by HexChat
+/// (that is, a null-terminated array whose first index is reserved),
+/// valid for the duration of the call.
+///
+/// The plugin state must have been initialized (see [`init_plugin`]).
+#[doc(hidden)]
+pub unsafe fn replay_print_event(name: &str, word: *mut *mut c_char) -> usize {
+    let mut invoked = 0;
+    let mut index = 0;
+    while let Some((found, (callback, userdata))) = next_captured_hook(index, |hook| match hook {
+        CapturedHook::Print {
+            name: hook_name,
+            callback,
+            userdata,
+        } if hook_name == name => Some((*callback, *userdata)),
+        _ => None,
+    }) {
+        index = found + 1;
+        callback(word, userdata);
+        invoked += 1;
+    }
+    invoked
+}
+
+/// UNSTABLE: do not call this function.
+///
+/// Replays a server event (or command, if `command` is true) through every live hook
+/// captured for `name` by [`mock_harness_vtable`], as HexChat does when the event fires.
+/// Returns the number of hooks invoked.
+///
+/// # Safety
+///
+/// `word` and `word_eol` must be `word`/`word_eol` pointers as passed by HexChat
+/// (that is, null-terminated arrays whose first index is reserved),
+/// valid for the duration of the call.
+///
+/// The plugin state must have been initialized (see [`init_plugin`]).
+#[doc(hidden)]
+pub unsafe fn replay_server_event(
+    name: &str,
+    command: bool,
+    word: *mut *mut c_char,
+    word_eol: *mut *mut c_char,
+) -> usize {
+    let mut invoked = 0;
+    let mut index = 0;
+    while let Some((found, (callback, userdata))) = next_captured_hook(index, |hook| match hook {
+        CapturedHook::Server {
+            name: hook_name,
+            callback,
+            userdata,
+        } if !command && hook_name == name => Some((*callback, *userdata)),
+        CapturedHook::Command {
+            name: hook_name,
+            callback,
+            userdata,
+        } if command && hook_name == name => Some((*callback, *userdata)),
+        _ => None,
+    }) {
+        index = found + 1;
+        callback(word, word_eol, userdata);
+        invoked += 1;
+    }
+    invoked
+}
+
+/// UNSTABLE: do not call this function.
+///
+/// Fires every live timer hook captured by [`mock_harness_vtable`] once,
+/// removing timers whose callback returns 0 as HexChat does.
+/// Returns the number of timers fired.
+///
+/// # Safety
+///
+/// The plugin state must have been initialized (see [`init_plugin`]).
+#[doc(hidden)]
+pub unsafe fn replay_timers() -> usize {
+    let mut fired = 0;
+    let mut index = 0;
+    while let Some((found, (callback, userdata))) = next_captured_hook(index, |hook| match hook {
+        CapturedHook::Timer { callback, userdata } => Some((*callback, *userdata)),
+        _ => None,
+    }) {
+        index = found + 1;
+        if callback(userdata) == 0 {
+            CAPTURED_HOOKS.with(|hooks| hooks.borrow_mut()[found] = None);
+        }
+        fired += 1;
+    }
+    fired
+}
+
+/// A synthetic list served by [`mock_harness_vtable`]'s list functions.
+struct MockList {
+    /// 1-based row, 0 before the first `hexchat_list_next`.
+    row: usize,
+    len: usize,
+    /// Owns the strings returned by `hexchat_list_str`, which HexChat keeps alive
+    /// for the life of the list.
+    strings: Vec<CString>,
+}
+
+/// UNSTABLE: do not call this function.
+///
+/// Creates a `hexchat_plugin` vtable which behaves like a minimal headless HexChat:
+/// hook registrations are captured and can be replayed
+/// (see [`replay_print_event`], [`replay_server_event`] and [`replay_timers`]),
+/// and the list functions serve synthetic `"channels"` and `"users"` lists
+/// (other list names are unavailable).
+/// All other entries fall back to the stubs of [`mock_plugin_vtable`].
+///
+/// The harness is single-threaded, like HexChat itself:
+/// all captured state is thread-local.
+#[doc(hidden)]
+pub fn mock_harness_vtable() -> hexchat_plugin {
+    unsafe extern "C" fn hook_command(
+        _ph: *mut hexchat_plugin,
+        name: *const c_char,
+        _pri: c_int,
+        callback: unsafe extern "C" fn(*mut *mut c_char, *mut *mut c_char, *mut c_void) -> c_int,
+        _help_text: *const c_char,
+        userdata: *mut c_void,
+    ) -> *mut hexchat_hook {
+        record_ffi_call();
+        capture_hook(CapturedHook::Command {
+            name: CStr::from_ptr(name).to_str().unwrap().to_owned(),
+            callback,
+            userdata,
+        })
+    }
+
+    unsafe extern "C" fn hook_server(
+        _ph: *mut hexchat_plugin,
+        name: *const c_char,
+        _pri: c_int,
+        callback: unsafe extern "C" fn(*mut *mut c_char, *mut *mut c_char, *mut c_void) -> c_int,
+        userdata: *mut c_void,
+    ) -> *mut hexchat_hook {
+        record_ffi_call();
+        capture_hook(CapturedHook::Server {
+            name: CStr::from_ptr(name).to_str().unwrap().to_owned(),
+            callback,
+            userdata,
+        })
+    }
+
+    unsafe extern "C" fn hook_print(
+        _ph: *mut hexchat_plugin,
+        name: *const c_char,
+        _pri: c_int,
+        callback: unsafe extern "C" fn(*mut *mut c_char, *mut c_void) -> c_int,
+        userdata: *mut c_void,
+    ) -> *mut hexchat_hook {
+        record_ffi_call();
+        capture_hook(CapturedHook::Print {
+            name: CStr::from_ptr(name).to_str().unwrap().to_owned(),
+            callback,
+            userdata,
+        })
+    }
+
+    unsafe extern "C" fn hook_timer(
+        _ph: *mut hexchat_plugin,
+        _timeout: c_int,
+        callback: unsafe extern "C" fn(*mut c_void) -> c_int,
+        userdata: *mut c_void,
+    ) -> *mut hexchat_hook {
+        record_ffi_call();
+        capture_hook(CapturedHook::Timer { callback, userdata })
+    }
+
+    unsafe extern "C" fn hook_fd(
+        _ph: *mut hexchat_plugin,
+        _fd: c_int,
+        _flags: c_int,
+        _callback: unsafe extern "C" fn(c_int, c_int, *mut c_void) -> c_int,
+        _userdata: *mut c_void,
+    ) -> *mut hexchat_hook {
+        record_ffi_call();
+        capture_hook(CapturedHook::Other)
+    }
+
+    unsafe extern "C" fn hook_server_attrs(
+        _ph: *mut hexchat_plugin,
+        _name: *const c_char,
+        _pri: c_int,
+        _callback: unsafe extern "C" fn(
+            *mut *mut c_char,
+            *mut *mut c_char,
+            *mut hexchat_event_attrs,
+            *mut c_void,
+        ) -> c_int,
+        _userdata: *mut c_void,
+    ) -> *mut hexchat_hook {
+        record_ffi_call();
+        capture_hook(CapturedHook::Other)
+    }
+
+    unsafe extern "C" fn hook_print_attrs(
+        _ph: *mut hexchat_plugin,
+        _name: *const c_char,
+        _pri: c_int,
+        _callback: unsafe extern "C" fn(
+            *mut *mut c_char,
+            *mut hexchat_event_attrs,
+            *mut c_void,
+        ) -> c_int,
+        _userdata: *mut c_void,
+    ) -> *mut hexchat_hook {
+        record_ffi_call();
+        capture_hook(CapturedHook::Other)
+    }
+
+    unsafe extern "C" fn unhook(_ph: *mut hexchat_plugin, hook: *mut hexchat_hook) -> *mut c_void {
+        record_ffi_call();
+        CAPTURED_HOOKS.with(|hooks| hooks.borrow_mut()[hook as usize - 1] = None);
+        ptr::null_mut()
+    }
+
+    unsafe extern "C" fn list_get(
+        _ph: *mut hexchat_plugin,
+        name: *const c_char,
+    ) -> *mut hexchat_list {
+        record_ffi_call();
+        let list = match CStr::from_ptr(name).to_bytes() {
+            b"channels" => MockList {
+                row: 0,
+                len: 16,
+                strings: Vec::new(),
+            },
+            b"users" => MockList {
+                row: 0,
+                len: 128,
+                strings: Vec::new(),
+            },
+            _ => return ptr::null_mut(),
+        };
+        Box::into_raw(Box::new(list)).cast()
+    }
+
+    unsafe extern "C" fn list_free(_ph: *mut hexchat_plugin, xlist: *mut hexchat_list) {
+        record_ffi_call();
+        // Safety: xlist was allocated by `list_get`
+        drop(Box::from_raw(xlist.cast::<MockList>()));
+    }
+
+    unsafe extern "C" fn list_next(_ph: *mut hexchat_plugin, xlist: *mut hexchat_list) -> c_int {
+        record_ffi_call();
+        let list = &mut *xlist.cast::<MockList>();
+        if list.row < list.len {
+            list.row += 1;
+            1
+        } else {
+            0
+        }
+    }
+
+    unsafe extern "C" fn list_str(
+        _ph: *mut hexchat_plugin,
+        xlist: *mut hexchat_list,
+        name: *const c_char,
+    ) -> *const c_char {
+        record_ffi_call();
+        let list = &mut *xlist.cast::<MockList>();
+        let field = CStr::from_ptr(name).to_str().unwrap();
+        let value = match field {
+            "channel" => format!("#chan{}", list.row),
+            "nick" => format!("nick{}", list.row),
+            "host" => format!("user{0}@host{0}", list.row),
+            // must be at most one character
+            "prefix" => "@".to_owned(),
+            _ => format!("{}{}", field, list.row),
+        };
+        let value = CString::new(value).unwrap();
+        let ptr = value.as_ptr();
+        list.strings.push(value);
+        ptr
+    }
+
+    unsafe extern "C" fn list_int(
+        _ph: *mut hexchat_plugin,
+        xlist: *mut hexchat_list,
+        name: *const c_char,
+    ) -> c_int {
+        record_ffi_call();
+        let list = &mut *xlist.cast::<MockList>();
+        match CStr::from_ptr(name).to_bytes() {
+            // `ChannelType::Channel`; other values would be rejected
+            b"type" => 2,
+            // `ChannelFlags::CONNECTED`
+            b"flags" => 1,
+            b"away" | b"selected" => (list.row % 2) as c_int,
+            _ => list.row as c_int,
+        }
+    }
+
+    unsafe extern "C" fn list_time(
+        _ph: *mut hexchat_plugin,
+        xlist: *mut hexchat_list,
+        _name: *const c_char,
+    ) -> time_t {
+        record_ffi_call();
+        let list = &*xlist.cast::<MockList>();
+        list.row as time_t
+    }
+
+    hexchat_plugin {
+        hexchat_hook_command: hook_command,
+        hexchat_hook_server: hook_server,
+        hexchat_hook_print: hook_print,
+        hexchat_hook_timer: hook_timer,
+        hexchat_hook_fd: hook_fd,
+        hexchat_hook_server_attrs: hook_server_attrs,
+        hexchat_hook_print_attrs: hook_print_attrs,
+        hexchat_unhook: unhook,
+        hexchat_list_get: list_get,
+        hexchat_list_free: list_free,
+        hexchat_list_next: list_next,
+        hexchat_list_str: list_str,
+        hexchat_list_int: list_int,
+        hexchat_list_time: list_time,
+        ..mock_plugin_vtable()
+    }
+}
+
+/// UNSTABLE: do not use this type.
+///
+/// An owned `word`-style array in HexChat's layout:
+/// a reserved index 0, then the words, then a null terminator.
+#[doc(hidden)]
+#[derive(Debug)]
+pub struct WordArray {
+    _words: Vec<CString>,
+    array: Vec<*mut c_char>,
+}
+
+impl WordArray {
+    /// Creates a `word`-style array holding `words`.
+    ///
+    /// HexChat always passes 32 entries to hook callbacks;
+    /// pass trailing empty strings to match its layout exactly.
+    pub fn new(words: impl IntoIterator<Item = String>) -> Self {
+        let words: Vec<_> = words
+            .into_iter()
+            .map(|w| CString::new(w).unwrap())
+            .collect();
+        let mut array = Vec::with_capacity(words.len() + 2);
+        array.push(ptr::null_mut());
+        array.extend(words.iter().map(|w| w.as_ptr() as *mut c_char));
+        array.push(ptr::null_mut());
+        Self {
+            _words: words,
+            array,
+        }
+    }
+
+    /// The `word` pointer, valid for as long as `self` is not moved or dropped.
+    pub fn as_word(&mut self) -> *mut *mut c_char {
+        self.array.as_mut_ptr()
+    }
+}
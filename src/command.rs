@@ -0,0 +1,320 @@
+//! Command batching and lazy command arguments.
+
+use std::fmt::Write;
+use std::iter;
+use std::marker::PhantomData;
+use std::os::raw::c_char;
+
+use crate::ffi::{word_nth, word_to_iter};
+use crate::plugin::PluginHandle;
+
+/// A lazy view of the words passed to a command hook.
+///
+/// Passed to hook callbacks registered with
+/// [`PluginHandle::hook_command_lazy`](crate::PluginHandle::hook_command_lazy).
+///
+/// Unlike the `&[&str]` passed by [`PluginHandle::hook_command`](crate::PluginHandle::hook_command),
+/// which decodes and UTF-8-validates every word up front,
+/// a `LazyWords` decodes a word only when it is accessed,
+/// so a callback which inspects a few arguments of a long command line skips the rest entirely.
+/// Nothing is cached: accessing the same word twice decodes it twice,
+/// so store the result in a local if you need it repeatedly.
+///
+/// As with [`PluginHandle::hook_command`](crate::PluginHandle::hook_command),
+/// word 0 is the name of the command, so word 1 is the first user-provided argument.
+#[derive(Debug, Copy, Clone)]
+pub struct LazyWords<'a> {
+    /// Always a valid `word` pointer, per `LazyWords::new`.
+    word: *mut *mut c_char,
+    _lifetime: PhantomData<&'a c_char>,
+}
+
+impl<'a> LazyWords<'a> {
+    /// Creates a lazy view of a command's words.
+    ///
+    /// # Safety
+    ///
+    /// `word` must be a `word` pointer from HexChat, valid for the entire lifetime `'a`.
+    pub(crate) unsafe fn new(word: *mut *mut c_char) -> Self {
+        Self {
+            word,
+            _lifetime: PhantomData,
+        }
+    }
+
+    /// Decodes and returns one word, or `None` if there are fewer than `index + 1` words.
+    ///
+    /// # Panics
+    ///
+    /// If the word contains invalid UTF8.
+    pub fn get(self, index: usize) -> Option<&'a str> {
+        // Safety: per `LazyWords::new`, `word` is always valid
+        let word = unsafe { word_nth(self.word, index) }?;
+        let word = word
+            .to_str()
+            .unwrap_or_else(|e| panic!("Invalid UTF8 in field index {}: {}", index, e));
+        Some(word)
+    }
+
+    /// Returns the number of words, without decoding any of them.
+    pub fn len(self) -> usize {
+        // Safety: per `LazyWords::new`, `word` is always valid
+        unsafe { word_to_iter(&self.word) }.count()
+    }
+
+    /// Returns `true` if there are no words.
+    pub fn is_empty(self) -> bool {
+        // Safety: per `LazyWords::new`, `word` is always valid
+        unsafe { word_nth(self.word, 0) }.is_none()
+    }
+
+    /// Returns an iterator which lazily decodes each word in turn.
+    pub fn iter(self) -> impl Iterator<Item = &'a str> {
+        let mut word = self.word;
+        let mut index = 0;
+        iter::from_fn(move || {
+            // Safety: per `LazyWords::new`, `word` is always valid,
+            // and it is only advanced past entries which exist
+            let next = unsafe { word_nth(word, 0) }?;
+            // Safety: the entry just read exists, so the array has at least one more (possibly null) entry
+            word = unsafe { word.add(1) };
+            let next = next
+                .to_str()
+                .unwrap_or_else(|e| panic!("Invalid UTF8 in field index {}: {}", index, e));
+            index += 1;
+            Some(next)
+        })
+    }
+}
+
+/// A batch of commands to be executed together.
+///
+/// [`PluginHandle::command`](crate::PluginHandle::command) performs one string conversion
+/// and one FFI call per command, which adds up when issuing hundreds of commands at once
+/// (e.g. a kick/ban sweep of a large channel).
+/// A `CommandBatch` instead accumulates commands into a single reused buffer,
+/// which [`PluginHandle::send_batch`](crate::PluginHandle::send_batch) flushes in one pass;
+/// [`PluginHandle::send_batch_limited`](crate::PluginHandle::send_batch_limited)
+/// can spread the flush across timer ticks to avoid stalling the event loop.
+/// See [`PluginHandle::send_batch_limited`](crate::PluginHandle::send_batch_limited) for an example.
+///
+/// The buffer's capacity is retained across flushes,
+/// so a long-lived `CommandBatch` stops allocating once it has grown to its working size.
+#[derive(Debug, Default)]
+pub struct CommandBatch {
+    /// Command strings stored back-to-back, each null-terminated.
+    buf: String,
+    /// Byte offset of the start of each unsent command in `buf`.
+    offsets: Vec<usize>,
+}
+
+impl CommandBatch {
+    /// Creates a new, empty `CommandBatch`.
+    pub fn new() -> Self {
+        Self::default()
+    }
+
+    /// Appends a command to the batch.
+    ///
+    /// As with [`PluginHandle::command`](crate::PluginHandle::command),
+    /// do not include the leading slash.
+    ///
+    /// # Panics
+    ///
+    /// If `cmd` contains a null byte.
+    pub fn push(&mut self, cmd: &str) {
+        assert!(
+            !cmd.as_bytes().contains(&0),
+            "Interior null byte in command: {:?}",
+            cmd
+        );
+        self.offsets.push(self.buf.len());
+        self.buf.push_str(cmd);
+        self.buf.push('\0');
+    }
+
+    /// Appends a formatted command to the batch, without allocating an intermediate string.
+    ///
+    /// # Panics
+    ///
+    /// If the formatted command contains a null byte.
+    pub fn push_fmt(&mut self, args: std::fmt::Arguments<'_>) {
+        let offset = self.buf.len();
+        self.buf
+            .write_fmt(args)
+            .unwrap_or_else(|e| panic!("Formatting failed: {}", e));
+        assert!(
+            !self.buf.as_bytes()[offset..].contains(&0),
+            "Interior null byte in command: {:?}",
+            &self.buf[offset..]
+        );
+        self.offsets.push(offset);
+        self.buf.push('\0');
+    }
+
+    /// Returns the number of commands waiting to be sent.
+    pub fn len(&self) -> usize {
+        self.offsets.len()
+    }
+
+    /// Returns `true` if there are no commands waiting to be sent.
+    pub fn is_empty(&self) -> bool {
+        self.offsets.is_empty()
+    }
+
+    /// Discards all commands without sending them.
+    pub fn clear(&mut self) {
+        self.buf.clear();
+        self.offsets.clear();
+    }
+
+    /// Calls `f` with each of the first `limit` null-terminated commands, then removes them.
+    ///
+    /// Returns the number of commands still waiting.
+    fn flush_front(&mut self, limit: usize, mut f: impl FnMut(*const c_char)) -> usize {
+        let limit = limit.min(self.offsets.len());
+        for &offset in &self.offsets[..limit] {
+            f(self.buf[offset..].as_ptr().cast());
+        }
+
+        self.offsets.drain(..limit);
+        if self.offsets.is_empty() {
+            // nothing left to send, reclaim the buffer (this keeps its capacity)
+            self.buf.clear();
+        }
+        self.offsets.len()
+    }
+}
+
+/// [Command Batching](crate::command::CommandBatch)
+impl<'ph, P> PluginHandle<'ph, P> {
+    /// Executes all commands in a batch, leaving it empty.
+    ///
+    /// Equivalent to calling [`PluginHandle::command`](crate::PluginHandle::command)
+    /// for each command in the batch, but without any per-command string conversion.
+    ///
+    /// # Examples
+    ///
+    /// ```rust
+    /// use hexavalent::PluginHandle;
+    /// use hexavalent::command::CommandBatch;
+    ///
+    /// fn kick_all<P>(ph: PluginHandle<'_, P>, batch: &mut CommandBatch, nicks: &[&str]) {
+    ///     for nick in nicks {
+    ///         batch.push_fmt(format_args!("KICK {}", nick));
+    ///     }
+    ///     ph.send_batch(batch);
+    /// }
+    /// ```
+    pub fn send_batch(self, batch: &mut CommandBatch) {
+        self.send_batch_limited(batch, usize::MAX);
+    }
+
+    /// Executes up to `limit` commands from the front of a batch,
+    /// returning the number of commands still waiting.
+    ///
+    /// Useful for spreading a large batch across timer ticks,
+    /// so that it does not block one event-loop iteration.
+    ///
+    /// # Examples
+    ///
+    /// ```rust
+    /// use std::cell::RefCell;
+    /// use std::time::Duration;
+    /// use hexavalent::{Plugin, PluginHandle};
+    /// use hexavalent::command::CommandBatch;
+    /// use hexavalent::hook::Timer;
+    ///
+    /// #[derive(Default)]
+    /// struct MyPlugin {
+    ///     batch: RefCell<CommandBatch>,
+    /// }
+    ///
+    /// fn kick_all_gradually(plugin: &MyPlugin, ph: PluginHandle<'_, MyPlugin>, nicks: &[&str]) {
+    ///     let mut batch = plugin.batch.borrow_mut();
+    ///     for nick in nicks {
+    ///         batch.push_fmt(format_args!("KICK {}", nick));
+    ///     }
+    ///
+    ///     // send 20 commands every 100 milliseconds until the batch is empty
+    ///     ph.hook_timer(Duration::from_millis(100), |plugin, ph| {
+    ///         match ph.send_batch_limited(&mut plugin.batch.borrow_mut(), 20) {
+    ///             0 => Timer::Stop,
+    ///             _ => Timer::Continue,
+    ///         }
+    ///     });
+    /// }
+    /// ```
+    pub fn send_batch_limited(self, batch: &mut CommandBatch, limit: usize) -> usize {
+        batch.flush_front(limit, |cmd| {
+            // Safety: `handle` is always valid; `cmd` points to a null-terminated string in the batch
+            unsafe {
+                ((*self.handle).hexchat_command)(self.handle, cmd);
+            }
+        })
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    fn commands(batch: &CommandBatch) -> Vec<&str> {
+        batch
+            .offsets
+            .iter()
+            .map(|&offset| &batch.buf[offset..batch.buf[offset..].find('\0').unwrap() + offset])
+            .collect()
+    }
+
+    #[test]
+    fn push_accumulates_commands() {
+        let mut batch = CommandBatch::new();
+        assert!(batch.is_empty());
+
+        batch.push("KICK alice");
+        batch.push_fmt(format_args!("KICK {}", "bob"));
+        assert_eq!(batch.len(), 2);
+        assert_eq!(commands(&batch), ["KICK alice", "KICK bob"]);
+
+        batch.clear();
+        assert!(batch.is_empty());
+    }
+
+    #[test]
+    fn flush_front_is_limited() {
+        fn flush(batch: &mut CommandBatch, limit: usize) -> Vec<String> {
+            let mut sent = Vec::new();
+            batch.flush_front(limit, |cmd| {
+                // Safety: `cmd` points to a null-terminated string in the batch
+                let cmd = unsafe { std::ffi::CStr::from_ptr(cmd) };
+                sent.push(cmd.to_str().unwrap().to_owned());
+            });
+            sent
+        }
+
+        let mut batch = CommandBatch::new();
+        batch.push("one");
+        batch.push("two");
+        batch.push("three");
+
+        assert_eq!(flush(&mut batch, 2), ["one", "two"]);
+        assert_eq!(commands(&batch), ["three"]);
+
+        assert_eq!(flush(&mut batch, usize::MAX), ["three"]);
+        assert!(batch.is_empty());
+        assert!(batch.buf.is_empty());
+    }
+
+    #[test]
+    #[should_panic]
+    fn push_invalid_null() {
+        CommandBatch::new().push("KICK\0alice");
+    }
+
+    #[test]
+    #[should_panic]
+    fn push_fmt_invalid_null() {
+        CommandBatch::new().push_fmt(format_args!("KICK{}alice", '\0'));
+    }
+}
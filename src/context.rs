@@ -1,9 +1,16 @@
 //! Server/channel contexts.
 
+use std::cell::RefCell;
+use std::collections::HashMap;
+use std::fmt::Write;
 use std::marker::PhantomData;
 use std::ptr::NonNull;
 
+use crate::event::print::special::{CloseContext, OpenContext};
+use crate::event::Event;
 use crate::ffi::hexchat_context;
+use crate::hook::{Eat, Priority};
+use crate::plugin::PluginHandle;
 
 /// Criteria used to find a server/channel context.
 ///
@@ -71,3 +78,300 @@ impl<'a> ContextHandle<'a> {
         self.handle
     }
 }
+
+/// A guard that keeps another context entered until it is dropped.
+///
+/// Returned by [`PluginHandle::enter_context`](crate::PluginHandle::enter_context).
+///
+/// While the guard is alive, every operation on the plugin handle
+/// (`print`, `command`, `emit_print`, `get_list`, and so on) runs in the entered context,
+/// paying one `hexchat_set_context` pair for the whole batch instead of one per operation
+/// as with repeated [`PluginHandle::with_context`](crate::PluginHandle::with_context) calls.
+/// Dropping the guard restores the context that was current when it was created.
+///
+/// Guards restore contexts in reverse creation order as they go out of scope,
+/// so nested guards behave like nested `with_context` calls.
+#[derive(Debug)]
+#[must_use = "the previous context is restored as soon as the guard is dropped"]
+pub struct ContextGuard<'ph> {
+    /// Always points to a valid instance of `hexchat_plugin`.
+    handle: *mut crate::ffi::hexchat_plugin,
+    /// The context that was current when this guard was created.
+    prev_context: *mut hexchat_context,
+    _lifetime: PhantomData<&'ph crate::ffi::hexchat_plugin>,
+}
+
+impl<'ph> ContextGuard<'ph> {
+    /// Creates a guard that restores `prev_context` when dropped.
+    ///
+    /// # Safety
+    ///
+    /// `handle` must point to a valid instance of `hexchat_plugin` for the entire lifetime `'ph`;
+    /// `prev_context` must be a context pointer obtained from HexChat.
+    pub(crate) unsafe fn new(
+        handle: *mut crate::ffi::hexchat_plugin,
+        prev_context: *mut hexchat_context,
+    ) -> Self {
+        Self {
+            handle,
+            prev_context,
+            _lifetime: PhantomData,
+        }
+    }
+}
+
+impl<'ph> Drop for ContextGuard<'ph> {
+    fn drop(&mut self) {
+        // Safety: handle is always valid; prev_context is a valid pointer
+        crate::ffi::int_to_result(unsafe {
+            ((*self.handle).hexchat_set_context)(self.handle, self.prev_context)
+        })
+        .unwrap_or_else(|_| panic!("Failed to switch back to original context"));
+    }
+}
+
+/// Builds the composite cache key for a (current context, servname, channel) triple into `key`.
+///
+/// `current` is part of the key for [`Context::Nearby`] resolutions,
+/// which prefer the channel on the current context's server:
+/// keying them by the context they were resolved from preserves that relativity
+/// (two contexts on the same server store duplicate entries for a channel,
+/// but entries never alias across servers).
+///
+/// `'\0'` cannot appear in either name
+/// (as with every string passed to HexChat, it would be rejected as an interior null),
+/// so it is usable as a separator.
+fn cache_key(
+    key: &mut String,
+    current: Option<NonNull<hexchat_context>>,
+    servname: Option<&str>,
+    channel: Option<&str>,
+) {
+    key.clear();
+    if let Some(current) = current {
+        write!(key, "{:p}", current).unwrap();
+    }
+    key.push('\0');
+    key.push_str(servname.unwrap_or(""));
+    key.push('\0');
+    key.push_str(channel.unwrap_or(""));
+}
+
+/// A cache of resolved server/channel contexts.
+///
+/// [`PluginHandle::find_context`](crate::PluginHandle::find_context) walks HexChat's entire session list,
+/// comparing names, every time it is called.
+/// A `ContextCache` remembers resolved [`Context::Nearby`] and [`Context::FullyQualified`] criteria,
+/// so repeatedly resolving the same names is a single hash lookup.
+/// The cache is invalidated when a context is opened or closed.
+///
+/// To use it, store a `ContextCache` in your plugin, implement `AsRef<ContextCache>`,
+/// call [`PluginHandle::hook_context_cache`](crate::PluginHandle::hook_context_cache)
+/// in [`Plugin::init`](crate::Plugin::init),
+/// and resolve contexts with [`ContextCache::find_context`].
+/// See [`ContextCache::find_context`] for an example.
+#[derive(Debug, Default)]
+pub struct ContextCache {
+    /// Map from composite name key to context, see [`cache_key`].
+    contexts: RefCell<HashMap<String, NonNull<hexchat_context>>>,
+    /// Reused key buffer, so that steady-state cache hits do not allocate.
+    scratch: RefCell<String>,
+}
+
+impl ContextCache {
+    /// Creates a new, empty `ContextCache`.
+    pub fn new() -> Self {
+        Self::default()
+    }
+
+    fn lookup(
+        &self,
+        current: Option<NonNull<hexchat_context>>,
+        servname: Option<&str>,
+        channel: Option<&str>,
+    ) -> Option<NonNull<hexchat_context>> {
+        let mut key = self.scratch.borrow_mut();
+        cache_key(&mut key, current, servname, channel);
+        self.contexts.borrow().get(key.as_str()).copied()
+    }
+
+    fn insert(
+        &self,
+        current: Option<NonNull<hexchat_context>>,
+        servname: Option<&str>,
+        channel: Option<&str>,
+        context: NonNull<hexchat_context>,
+    ) {
+        let mut key = self.scratch.borrow_mut();
+        cache_key(&mut key, current, servname, channel);
+        self.contexts.borrow_mut().insert(key.clone(), context);
+    }
+
+    /// Discards all cached contexts.
+    ///
+    /// Called automatically by the hooks registered in
+    /// [`PluginHandle::hook_context_cache`](crate::PluginHandle::hook_context_cache);
+    /// you should not normally need to call it yourself.
+    pub fn clear(&self) {
+        self.contexts.borrow_mut().clear();
+    }
+
+    /// Finds a server/channel context, like [`PluginHandle::find_context`](crate::PluginHandle::find_context),
+    /// but remembering resolved contexts so that repeated resolution of the same names
+    /// is a single hash lookup.
+    ///
+    /// [`Context::Nearby`] and [`Context::FullyQualified`] criteria are cached.
+    /// `Nearby` resolutions prefer the channel on the current server,
+    /// so they are keyed by the context they were resolved from
+    /// and stay correct for plugins active on several networks at once.
+    /// [`Context::Focused`] and [`Context::Frontmost`] depend on which tab is focused,
+    /// which the cache cannot observe, so they always fall through to
+    /// [`PluginHandle::find_context`](crate::PluginHandle::find_context).
+    ///
+    /// [`PluginHandle::hook_context_cache`] must have been called in
+    /// [`Plugin::init`](crate::Plugin::init), so that the cache is invalidated
+    /// when contexts are opened or closed.
+    ///
+    /// # Examples
+    ///
+    /// ```rust
+    /// use hexavalent::{Plugin, PluginHandle};
+    /// use hexavalent::context::{Context, ContextCache};
+    ///
+    /// #[derive(Default)]
+    /// struct MyPlugin {
+    ///     contexts: ContextCache,
+    /// }
+    ///
+    /// impl AsRef<ContextCache> for MyPlugin {
+    ///     fn as_ref(&self) -> &ContextCache {
+    ///         &self.contexts
+    ///     }
+    /// }
+    ///
+    /// impl Plugin for MyPlugin {
+    ///     fn init(&self, ph: PluginHandle<'_, Self>) {
+    ///         ph.hook_context_cache();
+    ///     }
+    /// }
+    ///
+    /// fn print_to_channel(plugin: &MyPlugin, ph: PluginHandle<'_, MyPlugin>, channel: &str, message: &str) {
+    ///     match plugin.contexts.find_context(ph, Context::Nearby { channel }) {
+    ///         Some(ctxt) => ph.with_context(ctxt, || ph.print(message)),
+    ///         None => ph.print("Channel not found!"),
+    ///     }
+    /// }
+    /// ```
+    pub fn find_context<'ph, P>(
+        &self,
+        ph: PluginHandle<'ph, P>,
+        find: Context<'_>,
+    ) -> Option<ContextHandle<'ph>> {
+        let (current, servname, channel) = match find {
+            Context::Focused | Context::Frontmost { .. } => return ph.find_context(find),
+            // `Nearby` prefers the channel on the current server,
+            // so the current context is part of the key (see `cache_key`)
+            Context::Nearby { channel } => (ph.raw_context(), None, Some(channel)),
+            Context::FullyQualified { servname, channel } => (None, Some(servname), Some(channel)),
+        };
+
+        if let Some(context) = self.lookup(current, servname, channel) {
+            // Safety: the pointer was valid when it was cached,
+            // and the hooks registered by `hook_context_cache` clear the cache
+            // before any context is destroyed
+            return Some(unsafe { ContextHandle::new(context) });
+        }
+
+        let context = ph.find_context(find)?;
+        self.insert(current, servname, channel, context.as_ptr());
+        Some(context)
+    }
+}
+
+/// [Context Cache](crate::context::ContextCache)
+impl<'ph, P: 'static + AsRef<ContextCache>> PluginHandle<'ph, P> {
+    /// Registers the print event hooks which invalidate a [`ContextCache`]
+    /// whenever a context is opened or closed.
+    ///
+    /// Call this once from [`Plugin::init`](crate::Plugin::init).
+    /// [`ContextCache::find_context`] is not safe to use without these hooks in place,
+    /// as the cache could hand out a handle to a context which no longer exists.
+    /// The registered hooks do not eat any events.
+    pub fn hook_context_cache(self) {
+        fn open_cb<P: 'static + AsRef<ContextCache>>(
+            plugin: &P,
+            _ph: PluginHandle<'_, P>,
+            _args: <OpenContext as Event<'_>>::Args,
+        ) -> Eat {
+            plugin.as_ref().clear();
+            Eat::None
+        }
+
+        fn close_cb<P: 'static + AsRef<ContextCache>>(
+            plugin: &P,
+            _ph: PluginHandle<'_, P>,
+            _args: <CloseContext as Event<'_>>::Args,
+        ) -> Eat {
+            plugin.as_ref().clear();
+            Eat::None
+        }
+
+        self.hook_print(OpenContext, Priority::Normal, open_cb);
+        self.hook_print(CloseContext, Priority::Normal, close_cb);
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn cache_keys_are_distinct() {
+        let mut a = String::new();
+        let mut b = String::new();
+
+        cache_key(&mut a, None, None, Some("#chan"));
+        cache_key(&mut b, None, Some("#chan"), None);
+        assert_ne!(a, b);
+
+        cache_key(&mut a, None, Some("serv"), Some("#chan"));
+        cache_key(&mut b, None, Some("serv"), Some("#chan"));
+        assert_eq!(a, b);
+    }
+
+    #[test]
+    fn nearby_cache_keys_depend_on_current_context() {
+        let ctxt_a = NonNull::<hexchat_context>::dangling();
+        // Safety: the pointer is never dereferenced, only formatted into the key
+        let ctxt_b =
+            unsafe { NonNull::new_unchecked(ctxt_a.as_ptr().cast::<u8>().wrapping_add(1).cast()) };
+
+        let mut a = String::new();
+        let mut b = String::new();
+
+        cache_key(&mut a, Some(ctxt_a), None, Some("#general"));
+        cache_key(&mut b, Some(ctxt_b), None, Some("#general"));
+        assert_ne!(a, b);
+
+        cache_key(&mut b, Some(ctxt_a), None, Some("#general"));
+        assert_eq!(a, b);
+    }
+
+    #[test]
+    fn cache_lookup_roundtrip() {
+        let cache = ContextCache::new();
+        let context = NonNull::dangling();
+
+        assert_eq!(cache.lookup(None, Some("serv"), Some("#chan")), None);
+
+        cache.insert(None, Some("serv"), Some("#chan"), context);
+        assert_eq!(
+            cache.lookup(None, Some("serv"), Some("#chan")),
+            Some(context)
+        );
+        assert_eq!(cache.lookup(None, None, Some("#chan")), None);
+
+        cache.clear();
+        assert_eq!(cache.lookup(None, Some("serv"), Some("#chan")), None);
+    }
+}
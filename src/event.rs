@@ -1,6 +1,7 @@
 //! Print and server events.
 
 use std::marker::PhantomData;
+use std::os::raw::c_char;
 
 use time::OffsetDateTime;
 
@@ -76,6 +77,12 @@ pub(crate) mod private {
         /// Must point to a valid, null-terminated C-style string.
         const NAME: *const c_char;
 
+        /// The number of fields in this event.
+        const FIELD_COUNT: usize;
+
+        /// The index of the field which is decoded from `word_eol` instead of `word`, if any.
+        const EOL_INDEX: Option<usize>;
+
         /// Converts this event's args to C-style strings.
         fn args_to_c<R>(args: impl Into<Self::ArgsImpl>, f: impl FnOnce(&[&CStr]) -> R) -> R;
 
@@ -156,18 +163,18 @@ macro_rules! event {
             // Safety: this string is null-terminated and static
             const NAME: *const ::std::os::raw::c_char = concat!($event_name, "\0").as_ptr().cast();
 
-            #[allow(unused_variables)]
+            const FIELD_COUNT: usize = $struct_name::FIELD_COUNT;
+
+            const EOL_INDEX: ::std::option::Option<usize> = {
+                #[allow(unused_mut, unused_assignments)]
+                let mut eol = ::std::option::Option::None;
+                $( eol = ::std::option::Option::Some($eol_index); )?
+                eol
+            };
+
             fn args_to_c<R>(args: impl Into<Self::ArgsImpl>, f: impl FnOnce(&[&::std::ffi::CStr]) -> R) -> R {
                 let args: Self::ArgsImpl = args.into();
-                let args: [::std::borrow::Cow::<'_, ::std::ffi::CStr>; Self::FIELD_COUNT] = [
-                    $(crate::ffi::StrExt::into_cstr(args[$index])),*
-                    $(, crate::ffi::StrExt::into_cstr(args[$eol_index]))?
-                ];
-                let args = [
-                    $(args[$index].as_ref()),*
-                    $(, args[$eol_index].as_ref())?
-                ];
-                f(&args)
+                crate::ffi::with_cstr_array(args, |args| f(args))
             }
 
             #[allow(unused_variables)]
@@ -199,6 +206,9 @@ macro_rules! event {
                             })
                     ),*
                     $(,
+                        // the eol field covers exactly the words not decoded from `word` above,
+                        // so each byte of the line is validated once; `nth` skips the leading
+                        // `word_eol` entries without decoding them (see `WordIter::nth`)
                         word_eol
                             .nth($eol_index)
                             .unwrap_or_else(|| {
@@ -226,6 +236,210 @@ macro_rules! event {
     };
 }
 
+/// A lazy view of an event's arguments.
+///
+/// Passed to hook callbacks registered with
+/// [`PluginHandle::hook_print_lazy`](crate::PluginHandle::hook_print_lazy) and
+/// [`PluginHandle::hook_server_lazy`](crate::PluginHandle::hook_server_lazy).
+///
+/// Unlike the [`Event::Args`] array, which decodes and UTF-8-validates every field up front,
+/// a `LazyArgs` decodes a field only when it is accessed with [`LazyArgs::arg`],
+/// so a callback which inspects one field of a high-volume event skips the rest entirely.
+/// Nothing is cached: accessing the same field twice decodes it twice,
+/// so store the result in a local if you need it repeatedly.
+///
+/// Fields are numbered as in the event's field list documentation, e.g.
+/// [`ChannelMessage`](print::ChannelMessage)'s `The text` field has index 1.
+#[derive(Debug)]
+pub struct LazyArgs<'a, E> {
+    /// Always a valid `word` pointer, per `LazyArgs::new`.
+    word: *mut *mut c_char,
+    /// Always a valid `word_eol` pointer for events with an eol field, per `LazyArgs::new`.
+    word_eol: *mut *mut c_char,
+    _lifetime: PhantomData<&'a c_char>,
+    _event: PhantomData<E>,
+}
+
+impl<'a, E> Copy for LazyArgs<'a, E> {}
+impl<'a, E> Clone for LazyArgs<'a, E> {
+    fn clone(&self) -> Self {
+        *self
+    }
+}
+
+impl<'a, E> LazyArgs<'a, E> {
+    /// Creates a lazy view of an event's arguments.
+    ///
+    /// # Safety
+    ///
+    /// `word` must be a `word` pointer from HexChat, valid for the entire lifetime `'a`.
+    ///
+    /// `word_eol` must be the corresponding `word_eol` pointer, valid for the entire lifetime `'a`,
+    /// unless `E` has no eol field (as with print events), in which case it may be null.
+    pub(crate) unsafe fn new(word: *mut *mut c_char, word_eol: *mut *mut c_char) -> Self {
+        Self {
+            word,
+            word_eol,
+            _lifetime: PhantomData,
+            _event: PhantomData,
+        }
+    }
+}
+
+impl<'a, E: Event<'a>> LazyArgs<'a, E> {
+    /// Decodes and returns one field of the event.
+    ///
+    /// # Panics
+    ///
+    /// If `index` is not less than the event's field count,
+    /// if the event contains fewer fields than expected,
+    /// or if the field contains invalid UTF8.
+    pub fn arg(self, index: usize) -> &'a str {
+        assert!(
+            index < E::FIELD_COUNT,
+            "Field index {} out of range for event '{}' with {} fields",
+            index,
+            Self::event_name(),
+            E::FIELD_COUNT,
+        );
+
+        let field = if E::EOL_INDEX == Some(index) {
+            // Safety: per `LazyArgs::new`, `word_eol` is valid when `E` has an eol field
+            unsafe { crate::ffi::word_nth(self.word_eol, index) }
+        } else {
+            // Safety: per `LazyArgs::new`, `word` is always valid
+            unsafe { crate::ffi::word_nth(self.word, index) }
+        };
+
+        field
+            .unwrap_or_else(|| {
+                panic!(
+                    "Insufficient fields in event '{}': expected {}, found {}",
+                    Self::event_name(),
+                    E::FIELD_COUNT,
+                    index,
+                )
+            })
+            .to_str()
+            .unwrap_or_else(|e| {
+                panic!(
+                    "Invalid UTF8 in field index {} of event '{}': {}",
+                    index,
+                    Self::event_name(),
+                    e,
+                )
+            })
+    }
+
+    /// The event's name, for panic messages.
+    fn event_name() -> std::borrow::Cow<'static, str> {
+        // Safety: NAME is always a valid, null-terminated, static string
+        unsafe { std::ffi::CStr::from_ptr(E::NAME) }.to_string_lossy()
+    }
+}
+
 pub mod print;
 
 pub mod server;
+
+#[cfg(test)]
+mod tests {
+    use std::ffi::CString;
+    use std::ptr;
+
+    use super::private::EventImpl;
+    use super::server::Privmsg;
+    use super::*;
+
+    /// Builds a `word`-style array: index 0 reserved, then a pointer per word, then null.
+    fn make_words(words: &[&[u8]]) -> (Vec<CString>, Vec<*mut c_char>) {
+        let owned: Vec<CString> = words.iter().map(|w| CString::new(*w).unwrap()).collect();
+        let mut ptrs: Vec<*mut c_char> = Vec::with_capacity(owned.len() + 2);
+        ptrs.push(ptr::null_mut());
+        ptrs.extend(owned.iter().map(|w| w.as_ptr() as *mut c_char));
+        ptrs.push(ptr::null_mut());
+        (owned, ptrs)
+    }
+
+    #[test]
+    fn args_from_words_skip_leading_word_eol_entries() {
+        let (_w, mut word) =
+            make_words(&[b":alice!a@host", b"PRIVMSG", b"#chan", b":hello", b"world"]);
+        // the skipped `word_eol` entries are never decoded, so invalid UTF8 there is ignored
+        let (_we, mut word_eol) =
+            make_words(&[b"\xff", b"\xff", b"\xff", b":hello world", b"world"]);
+
+        let word = word.as_mut_ptr();
+        let word_eol = word_eol.as_mut_ptr();
+        // Safety: the arrays above are valid word-style arrays which outlive the call
+        let args: <Privmsg as Event<'_>>::Args = unsafe {
+            Privmsg::args_from_words(
+                crate::ffi::word_to_iter(&word),
+                crate::ffi::word_to_iter(&word_eol),
+            )
+        };
+
+        assert_eq!(args, [":alice!a@host", "PRIVMSG", "#chan", ":hello world"]);
+    }
+
+    #[test]
+    fn lazy_args_decode_on_access() {
+        let (_w, mut word) =
+            make_words(&[b":alice!a@host", b"PRIVMSG", b"#chan", b":hello", b"world"]);
+        let (_we, mut word_eol) = make_words(&[
+            b":alice!a@host PRIVMSG #chan :hello world",
+            b"PRIVMSG #chan :hello world",
+            b"#chan :hello world",
+            b":hello world",
+            b"world",
+        ]);
+
+        // Safety: the arrays above outlive `args`
+        let args: LazyArgs<'_, Privmsg> =
+            unsafe { LazyArgs::new(word.as_mut_ptr(), word_eol.as_mut_ptr()) };
+
+        assert_eq!(args.arg(0), ":alice!a@host");
+        assert_eq!(args.arg(2), "#chan");
+        // the eol field comes from `word_eol`
+        assert_eq!(args.arg(3), ":hello world");
+    }
+
+    #[test]
+    fn lazy_args_skip_unaccessed_fields() {
+        let (_w, mut word) = make_words(&[b":alice!a@host", b"\xff\xfe", b"#chan", b":hello"]);
+        let (_we, mut word_eol) = make_words(&[b"x", b"x", b"x", b":hello"]);
+
+        // Safety: the arrays above outlive `args`
+        let args: LazyArgs<'_, Privmsg> =
+            unsafe { LazyArgs::new(word.as_mut_ptr(), word_eol.as_mut_ptr()) };
+
+        // the invalid UTF8 in field index 1 does not matter unless that field is accessed
+        assert_eq!(args.arg(2), "#chan");
+    }
+
+    #[test]
+    #[should_panic]
+    fn lazy_args_invalid_utf8() {
+        let (_w, mut word) = make_words(&[b":alice!a@host", b"\xff\xfe", b"#chan", b":hello"]);
+        let (_we, mut word_eol) = make_words(&[b"x", b"x", b"x", b":hello"]);
+
+        // Safety: the arrays above outlive `args`
+        let args: LazyArgs<'_, Privmsg> =
+            unsafe { LazyArgs::new(word.as_mut_ptr(), word_eol.as_mut_ptr()) };
+
+        args.arg(1);
+    }
+
+    #[test]
+    #[should_panic]
+    fn lazy_args_out_of_range() {
+        let (_w, mut word) = make_words(&[b":alice!a@host", b"PRIVMSG", b"#chan", b":hello"]);
+        let (_we, mut word_eol) = make_words(&[b"x", b"x", b"x", b":hello"]);
+
+        // Safety: the arrays above outlive `args`
+        let args: LazyArgs<'_, Privmsg> =
+            unsafe { LazyArgs::new(word.as_mut_ptr(), word_eol.as_mut_ptr()) };
+
+        args.arg(Privmsg::FIELD_COUNT);
+    }
+}
@@ -66,13 +66,85 @@ macro_rules! print_event {
     };
 }
 
+macro_rules! print_event_registry {
+    ($(($event_name:literal, $struct_name:ident)),* $(,)?) => {
+        /// Metadata for every print event, sorted by name.
+        ///
+        /// Used by [`PluginHandle::hook_print_dyn`](crate::PluginHandle::hook_print_dyn)
+        /// to resolve an event name to its metadata at runtime.
+        pub(crate) static PRINT_EVENT_REGISTRY: &[crate::event::print::PrintEventEntry] = &[
+            $(
+                crate::event::print::PrintEventEntry {
+                    name: $event_name,
+                    name_c: concat!($event_name, "\0"),
+                    field_count: $struct_name::FIELD_COUNT,
+                },
+            )*
+        ];
+    };
+}
+
 mod impls;
 
 pub use impls::*;
 
+/// Metadata about a single print event, used for dynamic (by-name) dispatch.
+///
+/// See [`PluginHandle::hook_print_dyn`](crate::PluginHandle::hook_print_dyn).
+pub(crate) struct PrintEventEntry {
+    /// The event's name.
+    pub(crate) name: &'static str,
+    /// The event's name as a null-terminated string, as passed to HexChat.
+    pub(crate) name_c: &'static str,
+    /// The number of fields in the event.
+    pub(crate) field_count: usize,
+}
+
+/// Looks up a print event's metadata by name.
+///
+/// The lookup is a binary search over a static table generated alongside the event structs,
+/// so it performs no allocation.
+/// The special print events in [`special`] are not included.
+pub(crate) fn find_print_event(name: &str) -> Option<&'static PrintEventEntry> {
+    PRINT_EVENT_REGISTRY
+        .binary_search_by(|entry| entry.name.cmp(name))
+        .ok()
+        .map(|index| &PRINT_EVENT_REGISTRY[index])
+}
+
 /// Special print event types which can only be hooked, not emitted.
 ///
 /// Attempting to emit these events with emission functions such as [`PluginHandle::emit_print`](crate::PluginHandle::emit_print) will always fail.
 ///
 /// Analogous to the special print events documented for [`hexchat_hook_print`](https://hexchat.readthedocs.io/en/latest/plugins.html#c.hexchat_hook_print).
 pub mod special;
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn registry_is_sorted_by_name() {
+        for pair in PRINT_EVENT_REGISTRY.windows(2) {
+            assert!(
+                pair[0].name < pair[1].name,
+                "Registry entry '{}' is not sorted before '{}'",
+                pair[0].name,
+                pair[1].name,
+            );
+        }
+    }
+
+    #[test]
+    fn find_print_event_matches_event_metadata() {
+        let entry = find_print_event("Channel Message").unwrap();
+        assert_eq!(entry.name, "Channel Message");
+        assert_eq!(entry.name_c, "Channel Message\0");
+        assert_eq!(entry.field_count, 4);
+
+        let entry = find_print_event("Connected").unwrap();
+        assert_eq!(entry.field_count, 0);
+
+        assert!(find_print_event("Not An Event").is_none());
+    }
+}
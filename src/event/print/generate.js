@@ -57,9 +57,18 @@ function* generateRustLines() {
 		field_descriptions[key] = fields;
 	}
 
-	for (const { name, fields_key, format } of readTextEvents()) {
+	const events = [...readTextEvents()];
+
+	for (const { name, fields_key, format } of events) {
 		yield `print_event!(${nameToCamelCase(name)}, "${name}", "\`${format}\`", ${field_descriptions[fields_key].map((field, i) => `${i}: "${field}"`).join(', ')});`;
 	}
+
+	yield '';
+
+	// sorted by name so that the registry can be binary-searched
+	const sortedNames = events.map(({ name }) => name).sort();
+
+	yield `print_event_registry!(${sortedNames.map(name => `("${name}", ${nameToCamelCase(name)})`).join(', ')});`;
 }
 
 function main() {
@@ -190,3 +190,158 @@ print_event!(YourAction, "Your Action", "`%C20*$t%B$1%B %C30$2%O`", 0: "Nickname
 print_event!(YourInvitation, "Your Invitation", "`%C20*%O$tYou've invited %C18$1%O to %C22$2%O (%C24$3%O)`", 0: "Nick of person who have been invited", 1: "Channel Name", 2: "Server Name");
 print_event!(YourMessage, "Your Message", "`%C20%H<%H$4$1%H>%H%O%C30$t$2%O`", 0: "Nickname", 1: "The text", 2: "Mode char", 3: "Identified text");
 print_event!(YourNickChanging, "Your Nick Changing", "`%C20*%O$tYou are now known as %C18$2%O`", 0: "Old nickname", 1: "New nickname");
+
+print_event_registry!(
+    ("Add Notify", AddNotify),
+    ("Ban List", BanList),
+    ("Banned", Banned),
+    ("Beep", Beep),
+    ("CTCP Generic", CtcpGeneric),
+    ("CTCP Generic to Channel", CtcpGenericToChannel),
+    ("CTCP Send", CtcpSend),
+    ("CTCP Sound", CtcpSound),
+    ("CTCP Sound to Channel", CtcpSoundToChannel),
+    ("Capability Acknowledgement", CapabilityAcknowledgement),
+    ("Capability Deleted", CapabilityDeleted),
+    ("Capability List", CapabilityList),
+    ("Capability Request", CapabilityRequest),
+    ("Change Nick", ChangeNick),
+    ("Channel Action", ChannelAction),
+    ("Channel Action Hilight", ChannelActionHilight),
+    ("Channel Ban", ChannelBan),
+    ("Channel Creation", ChannelCreation),
+    ("Channel DeHalfOp", ChannelDehalfop),
+    ("Channel DeOp", ChannelDeop),
+    ("Channel DeVoice", ChannelDevoice),
+    ("Channel Exempt", ChannelExempt),
+    ("Channel Half-Operator", ChannelHalfOperator),
+    ("Channel INVITE", ChannelInvite),
+    ("Channel List", ChannelList),
+    ("Channel Message", ChannelMessage),
+    ("Channel Mode Generic", ChannelModeGeneric),
+    ("Channel Modes", ChannelModes),
+    ("Channel Msg Hilight", ChannelMsgHilight),
+    ("Channel Notice", ChannelNotice),
+    ("Channel Operator", ChannelOperator),
+    ("Channel Quiet", ChannelQuiet),
+    ("Channel Remove Exempt", ChannelRemoveExempt),
+    ("Channel Remove Invite", ChannelRemoveInvite),
+    ("Channel Remove Keyword", ChannelRemoveKeyword),
+    ("Channel Remove Limit", ChannelRemoveLimit),
+    ("Channel Set Key", ChannelSetKey),
+    ("Channel Set Limit", ChannelSetLimit),
+    ("Channel UnBan", ChannelUnban),
+    ("Channel UnQuiet", ChannelUnquiet),
+    ("Channel Url", ChannelUrl),
+    ("Channel Voice", ChannelVoice),
+    ("Connected", Connected),
+    ("Connecting", Connecting),
+    ("Connection Failed", ConnectionFailed),
+    ("DCC CHAT Abort", DccChatAbort),
+    ("DCC CHAT Connect", DccChatConnect),
+    ("DCC CHAT Failed", DccChatFailed),
+    ("DCC CHAT Offer", DccChatOffer),
+    ("DCC CHAT Offering", DccChatOffering),
+    ("DCC CHAT Reoffer", DccChatReoffer),
+    ("DCC Conection Failed", DccConectionFailed),
+    ("DCC Generic Offer", DccGenericOffer),
+    ("DCC Header", DccHeader),
+    ("DCC Malformed", DccMalformed),
+    ("DCC Offer", DccOffer),
+    ("DCC Offer Not Valid", DccOfferNotValid),
+    ("DCC RECV Abort", DccRecvAbort),
+    ("DCC RECV Complete", DccRecvComplete),
+    ("DCC RECV Connect", DccRecvConnect),
+    ("DCC RECV Failed", DccRecvFailed),
+    ("DCC RECV File Open Error", DccRecvFileOpenError),
+    ("DCC RESUME Request", DccResumeRequest),
+    ("DCC Rename", DccRename),
+    ("DCC SEND Abort", DccSendAbort),
+    ("DCC SEND Complete", DccSendComplete),
+    ("DCC SEND Connect", DccSendConnect),
+    ("DCC SEND Failed", DccSendFailed),
+    ("DCC SEND Offer", DccSendOffer),
+    ("DCC Stall", DccStall),
+    ("DCC Timeout", DccTimeout),
+    ("Delete Notify", DeleteNotify),
+    ("Disconnected", Disconnected),
+    ("Found IP", FoundIp),
+    ("Generic Message", GenericMessage),
+    ("Ignore Add", IgnoreAdd),
+    ("Ignore Changed", IgnoreChanged),
+    ("Ignore Footer", IgnoreFooter),
+    ("Ignore Header", IgnoreHeader),
+    ("Ignore Remove", IgnoreRemove),
+    ("Ignorelist Empty", IgnorelistEmpty),
+    ("Invite", Invite),
+    ("Invited", Invited),
+    ("Join", Join),
+    ("Keyword", Keyword),
+    ("Kick", Kick),
+    ("Killed", Killed),
+    ("MOTD Skipped", MotdSkipped),
+    ("Message Send", MessageSend),
+    ("Motd", Motd),
+    ("Nick Clash", NickClash),
+    ("Nick Erroneous", NickErroneous),
+    ("Nick Failed", NickFailed),
+    ("No DCC", NoDcc),
+    ("No Running Process", NoRunningProcess),
+    ("Notice", Notice),
+    ("Notice Send", NoticeSend),
+    ("Notify Away", NotifyAway),
+    ("Notify Back", NotifyBack),
+    ("Notify Empty", NotifyEmpty),
+    ("Notify Header", NotifyHeader),
+    ("Notify Number", NotifyNumber),
+    ("Notify Offline", NotifyOffline),
+    ("Notify Online", NotifyOnline),
+    ("Open Dialog", OpenDialog),
+    ("Part", Part),
+    ("Part with Reason", PartWithReason),
+    ("Ping Reply", PingReply),
+    ("Ping Timeout", PingTimeout),
+    ("Private Action", PrivateAction),
+    ("Private Action to Dialog", PrivateActionToDialog),
+    ("Private Message", PrivateMessage),
+    ("Private Message to Dialog", PrivateMessageToDialog),
+    ("Process Already Running", ProcessAlreadyRunning),
+    ("Quit", Quit),
+    ("Raw Modes", RawModes),
+    ("Receive Wallops", ReceiveWallops),
+    ("Resolving User", ResolvingUser),
+    ("SASL Authenticating", SaslAuthenticating),
+    ("SASL Response", SaslResponse),
+    ("SSL Message", SslMessage),
+    ("Server Connected", ServerConnected),
+    ("Server Error", ServerError),
+    ("Server Lookup", ServerLookup),
+    ("Server Notice", ServerNotice),
+    ("Server Text", ServerText),
+    ("Stop Connection", StopConnection),
+    ("Topic", Topic),
+    ("Topic Change", TopicChange),
+    ("Topic Creation", TopicCreation),
+    ("Unknown Host", UnknownHost),
+    ("User Limit", UserLimit),
+    ("Users On Channel", UsersOnChannel),
+    ("WhoIs Authenticated", WhoisAuthenticated),
+    ("WhoIs Away Line", WhoisAwayLine),
+    ("WhoIs Channel/Oper Line", WhoisChannelOperLine),
+    ("WhoIs End", WhoisEnd),
+    ("WhoIs Identified", WhoisIdentified),
+    ("WhoIs Idle Line", WhoisIdleLine),
+    ("WhoIs Idle Line with Signon", WhoisIdleLineWithSignon),
+    ("WhoIs Name Line", WhoisNameLine),
+    ("WhoIs Real Host", WhoisRealHost),
+    ("WhoIs Server Line", WhoisServerLine),
+    ("WhoIs Special", WhoisSpecial),
+    ("You Join", YouJoin),
+    ("You Kicked", YouKicked),
+    ("You Part", YouPart),
+    ("You Part with Reason", YouPartWithReason),
+    ("Your Action", YourAction),
+    ("Your Invitation", YourInvitation),
+    ("Your Message", YourMessage),
+    ("Your Nick Changing", YourNickChanging)
+);
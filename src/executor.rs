@@ -0,0 +1,456 @@
+//! Async task execution on the HexChat event loop.
+
+use std::cell::RefCell;
+use std::fmt;
+use std::future::Future;
+use std::marker::PhantomData;
+use std::mem;
+use std::pin::Pin;
+use std::rc::Rc;
+use std::sync::{Arc, Mutex};
+use std::task::{Context, Poll, Wake, Waker};
+use std::time::Duration;
+
+use crate::event::server::ServerEvent;
+use crate::event::Event;
+use crate::hook::{Eat, HookHandle, Priority, Timer};
+use crate::plugin::PluginHandle;
+use crate::state::with_plugin_state;
+
+/// Ids of tasks whose wakers have been invoked since the last poll pass.
+///
+/// Shared with wakers, which may nominally be `Send`, so it is a real mutex;
+/// in practice it is only ever locked briefly from HexChat's thread.
+struct ReadyQueue {
+    ids: Mutex<Vec<usize>>,
+}
+
+/// Wakes a task by marking it ready for the next poll pass.
+struct TaskWaker {
+    id: usize,
+    ready: Arc<ReadyQueue>,
+}
+
+impl Wake for TaskWaker {
+    fn wake(self: Arc<Self>) {
+        self.wake_by_ref();
+    }
+
+    fn wake_by_ref(self: &Arc<Self>) {
+        self.ready
+            .ids
+            .lock()
+            .unwrap_or_else(|e| panic!("Ready queue lock poisoned: {}", e))
+            .push(self.id);
+    }
+}
+
+struct ExecutorInner {
+    /// One slot per spawned task. `None` slots are free for reuse, or mid-poll.
+    slots: Vec<Option<Pin<Box<dyn Future<Output = ()>>>>>,
+    /// Indices of free slots in `slots`.
+    free_slots: Vec<usize>,
+}
+
+/// A single-threaded async executor polling futures on the HexChat event loop.
+///
+/// Multi-step workflows (send `WHOIS`, await the response, then decide) are usually
+/// written as state machines spread across hook callbacks and plugin-struct fields.
+/// An `Executor` lets you write them as `async` blocks instead:
+/// intermediate state lives on the future's own stack across `.await` points,
+/// and all tasks woken since the last tick are polled in one batch,
+/// driven by a single HexChat timer.
+///
+/// Futures are polled on HexChat's thread and need not be `Send`.
+/// Because a [`PluginHandle`] cannot be held across an `.await` point,
+/// use [`Executor::handle`] to get a lifetime-free [`AsyncHandle`]
+/// which can re-enter plugin state from inside a task.
+///
+/// To use it, store an `Executor` in your plugin, implement `AsRef<Executor<Self>>`,
+/// and call [`PluginHandle::hook_executor`] in [`Plugin::init`](crate::Plugin::init).
+/// See [`PluginHandle::hook_executor`] for an example.
+pub struct Executor<P> {
+    inner: RefCell<ExecutorInner>,
+    ready: Arc<ReadyQueue>,
+    _plugin: PhantomData<fn(P)>,
+}
+
+impl<P> fmt::Debug for Executor<P> {
+    fn fmt(&self, f: &mut fmt::Formatter<'_>) -> fmt::Result {
+        let inner = self.inner.borrow();
+        f.debug_struct("Executor")
+            .field("tasks", &(inner.slots.len() - inner.free_slots.len()))
+            .finish()
+    }
+}
+
+impl<P> Default for Executor<P> {
+    fn default() -> Self {
+        Self::new()
+    }
+}
+
+impl<P> Executor<P> {
+    /// Creates a new executor with no tasks.
+    pub fn new() -> Self {
+        Self {
+            inner: RefCell::new(ExecutorInner {
+                slots: Vec::new(),
+                free_slots: Vec::new(),
+            }),
+            ready: Arc::new(ReadyQueue {
+                ids: Mutex::new(Vec::new()),
+            }),
+            _plugin: PhantomData,
+        }
+    }
+
+    /// Returns a lifetime-free handle to plugin state, for use inside spawned tasks.
+    pub fn handle(&self) -> AsyncHandle<P> {
+        AsyncHandle {
+            _plugin: PhantomData,
+        }
+    }
+
+    /// Spawns a task onto the executor.
+    ///
+    /// The task is polled once immediately, then again on every
+    /// [`hook_executor`](PluginHandle::hook_executor) tick after one of its wakers is invoked.
+    /// Tasks run to completion and cannot be cancelled; when the plugin is unloaded,
+    /// unfinished tasks are dropped along with the plugin.
+    pub fn spawn(&self, future: impl Future<Output = ()> + 'static) {
+        let id = {
+            let mut inner = self.inner.borrow_mut();
+            let future: Pin<Box<dyn Future<Output = ()>>> = Box::pin(future);
+            match inner.free_slots.pop() {
+                Some(id) => {
+                    debug_assert!(inner.slots[id].is_none());
+                    inner.slots[id] = Some(future);
+                    id
+                }
+                None => {
+                    inner.slots.push(Some(future));
+                    inner.slots.len() - 1
+                }
+            }
+        };
+
+        self.poll_task(id);
+    }
+
+    /// Polls every task woken since the last tick.
+    ///
+    /// Wakes that happen during this pass (including a task re-waking itself)
+    /// are deferred to the next tick, so one slow tick cannot starve the event loop.
+    fn tick(&self) {
+        let ready = mem::take(
+            &mut *self
+                .ready
+                .ids
+                .lock()
+                .unwrap_or_else(|e| panic!("Ready queue lock poisoned: {}", e)),
+        );
+
+        for id in ready {
+            self.poll_task(id);
+        }
+    }
+
+    /// Polls one task, freeing its slot if it completes.
+    fn poll_task(&self, id: usize) {
+        // take the future out of its slot, so the executor is not borrowed while polling
+        // (the task may spawn other tasks, or synchronously trigger hooks which do)
+        let mut future = match self.inner.borrow_mut().slots[id].take() {
+            Some(future) => future,
+            // spurious wake of a completed (or reused and completed) task
+            None => return,
+        };
+
+        let waker = Waker::from(Arc::new(TaskWaker {
+            id,
+            ready: Arc::clone(&self.ready),
+        }));
+        let mut cx = Context::from_waker(&waker);
+
+        match future.as_mut().poll(&mut cx) {
+            Poll::Ready(()) => self.inner.borrow_mut().free_slots.push(id),
+            Poll::Pending => self.inner.borrow_mut().slots[id] = Some(future),
+        }
+    }
+}
+
+/// A lifetime-free handle to plugin state, for use inside spawned tasks.
+///
+/// A [`PluginHandle`] borrows the plugin and cannot be held across an `.await` point,
+/// so async tasks instead capture an `AsyncHandle` (obtained from [`Executor::handle`])
+/// and re-enter plugin state with [`AsyncHandle::with`] whenever they need it.
+pub struct AsyncHandle<P> {
+    _plugin: PhantomData<fn(P)>,
+}
+
+impl<P> fmt::Debug for AsyncHandle<P> {
+    fn fmt(&self, f: &mut fmt::Formatter<'_>) -> fmt::Result {
+        f.debug_struct("AsyncHandle").finish()
+    }
+}
+
+impl<P> Copy for AsyncHandle<P> {}
+
+impl<P> Clone for AsyncHandle<P> {
+    fn clone(&self) -> Self {
+        *self
+    }
+}
+
+impl<P: 'static> AsyncHandle<P> {
+    /// Re-enters plugin state, as if from a hook callback.
+    ///
+    /// # Panics
+    ///
+    /// If the plugin is not currently loaded, or is a different type than `P`.
+    /// Neither happens when called from a task spawned on the plugin's own [`Executor`],
+    /// since tasks are only polled while the plugin is loaded.
+    pub fn with<R>(self, f: impl FnOnce(&P, PluginHandle<'_, P>) -> R) -> R {
+        with_plugin_state(f)
+    }
+}
+
+struct EventFutureState<T> {
+    result: Option<T>,
+    waker: Option<Waker>,
+    hook: Option<HookHandle>,
+}
+
+/// A future resolving to the next occurrence of a server event.
+///
+/// Returned by [`PluginHandle::await_server_event`].
+pub struct EventFuture<T> {
+    state: Rc<RefCell<EventFutureState<T>>>,
+}
+
+impl<T> fmt::Debug for EventFuture<T> {
+    fn fmt(&self, f: &mut fmt::Formatter<'_>) -> fmt::Result {
+        f.debug_struct("EventFuture")
+            .field("ready", &self.state.borrow().result.is_some())
+            .finish()
+    }
+}
+
+impl<T> Future for EventFuture<T> {
+    type Output = T;
+
+    fn poll(self: Pin<&mut Self>, cx: &mut Context<'_>) -> Poll<T> {
+        let mut state = self.state.borrow_mut();
+        match state.result.take() {
+            Some(result) => Poll::Ready(result),
+            None => {
+                state.waker = Some(cx.waker().clone());
+                Poll::Pending
+            }
+        }
+    }
+}
+
+/// [Async Tasks](crate::executor::Executor)
+///
+/// Allows your plugin to run `async` tasks polled on the HexChat event loop.
+impl<'ph, P: 'static> PluginHandle<'ph, P> {
+    /// Returns a future resolving to the next occurrence of a server event.
+    ///
+    /// Since the event's arguments only live for the duration of the underlying hook callback,
+    /// `map` converts them to an owned value, which the future yields.
+    ///
+    /// The hook unregisters itself when the event first arrives.
+    /// Note that dropping the future does not unregister the hook;
+    /// it stays registered (resolving nothing) until the event next arrives,
+    /// or until your plugin is unloaded.
+    ///
+    /// See [`PluginHandle::hook_executor`] for an example.
+    pub fn await_server_event<E, T, F>(self, event: E, priority: Priority, map: F) -> EventFuture<T>
+    where
+        E: ServerEvent,
+        T: 'static,
+        F: for<'a> Fn(<E as Event<'a>>::Args) -> T + 'static,
+    {
+        let state = Rc::new(RefCell::new(EventFutureState {
+            result: None,
+            waker: None,
+            hook: None,
+        }));
+
+        let hook_state = Rc::clone(&state);
+        let hook = self.hook_server_with(event, priority, move |_plugin, ph, args| {
+            let mut state = hook_state.borrow_mut();
+            if state.result.is_none() {
+                state.result = Some(map(args));
+                // one-shot: the hook unregisters itself on the first occurrence
+                if let Some(hook) = state.hook.take() {
+                    ph.unhook(hook);
+                }
+                if let Some(waker) = state.waker.take() {
+                    waker.wake();
+                }
+            }
+            Eat::None
+        });
+        state.borrow_mut().hook = Some(hook);
+
+        EventFuture { state }
+    }
+}
+
+/// [Async Tasks](crate::executor::Executor)
+///
+/// Allows your plugin to run `async` tasks polled on the HexChat event loop.
+impl<'ph, P: 'static + AsRef<Executor<P>>> PluginHandle<'ph, P> {
+    /// Registers the single HexChat timer driving your plugin's [`Executor`].
+    ///
+    /// Every `resolution`, all tasks woken since the previous tick are polled in one batch.
+    ///
+    /// Call this once from [`Plugin::init`](crate::Plugin::init).
+    ///
+    /// Returns a [`HookHandle`](crate::hook::HookHandle) which can be passed to
+    /// [`PluginHandle::unhook`](crate::PluginHandle::unhook) to stop polling entirely.
+    ///
+    /// # Examples
+    ///
+    /// ```rust
+    /// use std::time::Duration;
+    /// use hexavalent::{Plugin, PluginHandle};
+    /// use hexavalent::event::server::Privmsg;
+    /// use hexavalent::executor::Executor;
+    /// use hexavalent::hook::Priority;
+    ///
+    /// #[derive(Default)]
+    /// struct MyPlugin {
+    ///     executor: Executor<MyPlugin>,
+    /// }
+    ///
+    /// impl AsRef<Executor<MyPlugin>> for MyPlugin {
+    ///     fn as_ref(&self) -> &Executor<MyPlugin> {
+    ///         &self.executor
+    ///     }
+    /// }
+    ///
+    /// impl Plugin for MyPlugin {
+    ///     fn init(&self, ph: PluginHandle<'_, Self>) {
+    ///         ph.hook_executor(Duration::from_millis(50));
+    ///
+    ///         let handle = self.executor.handle();
+    ///         let next_message = ph.await_server_event(Privmsg, Priority::Normal, |args| {
+    ///             let [sender, _, _, text] = args;
+    ///             format!("{} said {}", sender, text)
+    ///         });
+    ///         self.executor.spawn(async move {
+    ///             let message = next_message.await;
+    ///             handle.with(|plugin, ph| ph.print(&format!("{}\0", message)));
+    ///         });
+    ///     }
+    /// }
+    /// ```
+    pub fn hook_executor(self, resolution: Duration) -> HookHandle {
+        self.hook_timer(resolution, |plugin, _ph| {
+            plugin.as_ref().tick();
+            Timer::Continue
+        })
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use std::cell::Cell;
+
+    use super::*;
+
+    type TestExecutor = Executor<()>;
+
+    /// Yields `remaining` times, invoking its waker each time, before completing.
+    struct YieldTimes {
+        remaining: Cell<usize>,
+    }
+
+    impl Future for YieldTimes {
+        type Output = ();
+
+        fn poll(self: Pin<&mut Self>, cx: &mut Context<'_>) -> Poll<()> {
+            match self.remaining.get() {
+                0 => Poll::Ready(()),
+                remaining => {
+                    self.remaining.set(remaining - 1);
+                    cx.waker().wake_by_ref();
+                    Poll::Pending
+                }
+            }
+        }
+    }
+
+    #[test]
+    fn spawn_polls_to_completion() {
+        let executor = TestExecutor::new();
+        let done = Rc::new(Cell::new(false));
+
+        let task_done = Rc::clone(&done);
+        executor.spawn(async move {
+            YieldTimes {
+                remaining: Cell::new(1),
+            }
+            .await;
+            task_done.set(true);
+        });
+
+        // spawned tasks are polled once immediately, then once per tick after being woken
+        assert!(!done.get());
+        executor.tick();
+        assert!(done.get());
+        assert_eq!(executor.inner.borrow().free_slots, [0]);
+    }
+
+    #[test]
+    fn wakes_batch_into_one_poll_pass() {
+        let executor = TestExecutor::new();
+
+        executor.spawn(YieldTimes {
+            remaining: Cell::new(3),
+        });
+
+        // each tick polls the task exactly once, even though it re-wakes itself mid-pass
+        for _ in 0..3 {
+            assert!(executor.inner.borrow().free_slots.is_empty());
+            executor.tick();
+        }
+        assert_eq!(executor.inner.borrow().free_slots, [0]);
+    }
+
+    #[test]
+    fn event_future_resolves_when_woken() {
+        let executor = TestExecutor::new();
+        let state = Rc::new(RefCell::new(EventFutureState {
+            result: None,
+            waker: None,
+            hook: None,
+        }));
+        let got = Rc::new(Cell::new(0));
+
+        let future = EventFuture {
+            state: Rc::clone(&state),
+        };
+        let task_got = Rc::clone(&got);
+        executor.spawn(async move {
+            task_got.set(future.await);
+        });
+
+        // not ready: the task parked its waker in the future
+        assert_eq!(got.get(), 0);
+
+        // the "event" arrives
+        let waker = {
+            let mut state = state.borrow_mut();
+            state.result = Some(17);
+            state.waker.take().unwrap()
+        };
+        waker.wake();
+
+        executor.tick();
+        assert_eq!(got.get(), 17);
+    }
+}
@@ -1,6 +1,8 @@
-use std::borrow::Cow;
+use std::cell::Cell;
 use std::ffi::{CStr, CString};
 use std::marker::PhantomData;
+use std::mem;
+use std::ops::{Deref, Range};
 use std::os::raw::{c_char, c_int};
 
 use time::OffsetDateTime;
@@ -15,7 +17,10 @@ pub(crate) use binding::{
 };
 
 // types https://hexchat.readthedocs.io/en/latest/plugins.html#types-and-constants
-pub(crate) use binding::{hexchat_context, hexchat_event_attrs, hexchat_hook, hexchat_list};
+pub(crate) use binding::{hexchat_context, hexchat_event_attrs, hexchat_hook};
+// this is used publicly by the feature-gated benchmark exports
+#[allow(unreachable_pub)]
+pub use binding::hexchat_list;
 // this is used publicly by generated code
 pub use binding::hexchat_plugin;
 
@@ -44,18 +49,183 @@ pub(crate) trait StrExt {
 }
 
 impl<'a> StrExt for &'a str {
-    type CSTR = Cow<'a, CStr>;
+    type CSTR = CStrBuf<'a>;
 
     fn into_cstr(self) -> Self::CSTR {
         // check last byte up front to avoid scanning the string twice if it does not end with null
         if self.as_bytes().last().copied() == Some(0) {
-            Cow::Borrowed(CStr::from_bytes_with_nul(self.as_bytes()).unwrap())
-        } else {
-            Cow::Owned(CString::new(self).unwrap())
+            return CStrBuf::Borrowed(CStr::from_bytes_with_nul(self.as_bytes()).unwrap());
+        }
+
+        if self.len() < MAX_SCRATCH_LEN {
+            if let Some(mut buf) = take_scratch_buffer() {
+                // `CString::new` performs the same check on the owned path below
+                assert!(
+                    !self.as_bytes().contains(&0),
+                    "Interior null byte in string: {:?}",
+                    self
+                );
+                buf.clear();
+                buf.extend_from_slice(self.as_bytes());
+                buf.push(0);
+                return CStrBuf::Scratch(ScratchGuard { buf });
+            }
+        }
+
+        CStrBuf::Owned(CString::new(self).unwrap())
+    }
+}
+
+/// Strings longer than this are converted on the heap instead of in a scratch buffer,
+/// so that one oversized conversion does not pin a large allocation for the life of the plugin.
+///
+/// IRC lines are limited to 512 bytes, so in practice strings passed to HexChat are far shorter.
+const MAX_SCRATCH_LEN: usize = 4096;
+
+thread_local! {
+    /// Reusable, grow-once scratch buffers backing [`CStrBuf::Scratch`].
+    ///
+    /// HexChat invokes plugins from a single thread (as asserted in `state.rs`),
+    /// so in practice there is exactly one set of these buffers.
+    /// A buffer is taken out while in use; several slots are provided so that call sites
+    /// converting a few strings at once (e.g. `find_context`) also avoid the heap.
+    static SCRATCH: [Cell<Option<Vec<u8>>>; 4] = [
+        Cell::new(Some(Vec::new())),
+        Cell::new(Some(Vec::new())),
+        Cell::new(Some(Vec::new())),
+        Cell::new(Some(Vec::new())),
+    ];
+}
+
+fn take_scratch_buffer() -> Option<Vec<u8>> {
+    SCRATCH.with(|slots| slots.iter().find_map(|slot| slot.take()))
+}
+
+fn return_scratch_buffer(buf: Vec<u8>) {
+    // ignore failure during thread teardown, the buffer is just dropped
+    let _ = SCRATCH.try_with(|slots| {
+        let mut buf = Some(buf);
+        for slot in slots {
+            // every live guard corresponds to a taken slot, so an empty slot always exists,
+            // but be defensive and drop the buffer if there somehow is none
+            let existing = slot.take();
+            if existing.is_none() {
+                slot.set(buf.take());
+                break;
+            }
+            slot.set(existing);
+        }
+    });
+}
+
+/// A null-terminated string created by [`StrExt::into_cstr`].
+///
+/// Dereferences to [`CStr`].
+pub(crate) enum CStrBuf<'a> {
+    /// The original string was already null-terminated and is used in place.
+    Borrowed(&'a CStr),
+    /// The string was copied into a reused thread-local scratch buffer.
+    Scratch(ScratchGuard),
+    /// The string was copied to the heap,
+    /// because it was oversized or no scratch buffer was available.
+    Owned(CString),
+}
+
+/// Owns a scratch buffer from [`SCRATCH`], returning it when dropped.
+pub(crate) struct ScratchGuard {
+    /// Always holds a null-terminated string with no interior nulls.
+    buf: Vec<u8>,
+}
+
+impl Drop for ScratchGuard {
+    fn drop(&mut self) {
+        return_scratch_buffer(mem::take(&mut self.buf));
+    }
+}
+
+impl Deref for CStrBuf<'_> {
+    type Target = CStr;
+
+    fn deref(&self) -> &CStr {
+        match self {
+            CStrBuf::Borrowed(str) => str,
+            // Safety: the guard's buffer always holds a null-terminated string with no interior nulls
+            CStrBuf::Scratch(guard) => unsafe { CStr::from_bytes_with_nul_unchecked(&guard.buf) },
+            CStrBuf::Owned(str) => str,
         }
     }
 }
 
+impl AsRef<CStr> for CStrBuf<'_> {
+    fn as_ref(&self) -> &CStr {
+        self
+    }
+}
+
+/// Strings whose combined length exceeds this are spilled to the heap by [`with_cstr_array`].
+///
+/// IRC lines are limited to 512 bytes, so the arguments of a typical print event
+/// (which together make up at most one line) fit inline.
+const INLINE_ARGS_LEN: usize = 512;
+
+/// Where one string's null-terminated copy lives during [`with_cstr_array`].
+enum ArgSlot<'a> {
+    /// The original string was already null-terminated and is used in place.
+    Terminated(&'a CStr),
+    /// The string was copied into the shared stack buffer; holds its range including the null.
+    Inline(Range<usize>),
+    /// The string was copied to the heap because the stack buffer was full.
+    Spilled(CString),
+}
+
+/// Converts an array of strings to null-terminated strings and passes them to `f`.
+///
+/// All strings share a single fixed stack buffer, so converting several short strings
+/// at once (e.g. the arguments of a print event) touches neither the heap
+/// nor the scratch buffers used by [`StrExt::into_cstr`].
+/// Oversized strings spill to the heap individually.
+pub(crate) fn with_cstr_array<R, const N: usize>(
+    args: [&str; N],
+    f: impl FnOnce(&[&CStr; N]) -> R,
+) -> R {
+    let mut buf = [0u8; INLINE_ARGS_LEN];
+    let mut len = 0;
+
+    let slots = args.map(|arg| {
+        // check last byte up front to avoid scanning the string twice if it does not end with null
+        if arg.as_bytes().last().copied() == Some(0) {
+            return ArgSlot::Terminated(CStr::from_bytes_with_nul(arg.as_bytes()).unwrap());
+        }
+
+        if let Some(dest) = buf[len..].get_mut(..arg.len() + 1) {
+            // `CString::new` performs the same check on the spilled path below
+            assert!(
+                !arg.as_bytes().contains(&0),
+                "Interior null byte in string: {:?}",
+                arg
+            );
+            dest[..arg.len()].copy_from_slice(arg.as_bytes());
+            dest[arg.len()] = 0;
+            let range = len..len + arg.len() + 1;
+            len = range.end;
+            return ArgSlot::Inline(range);
+        }
+
+        ArgSlot::Spilled(CString::new(arg).unwrap())
+    });
+
+    let args: [&CStr; N] = std::array::from_fn(|i| match &slots[i] {
+        ArgSlot::Terminated(str) => str,
+        // Safety: inline ranges always hold a null-terminated string with no interior nulls
+        ArgSlot::Inline(range) => unsafe {
+            CStr::from_bytes_with_nul_unchecked(&buf[range.clone()])
+        },
+        ArgSlot::Spilled(str) => str,
+    });
+
+    f(&args)
+}
+
 /// Converts `word` or `word_eol` to an iterator over `&CStr`.
 ///
 /// # Safety
@@ -114,6 +284,42 @@ pub(crate) unsafe fn word_to_iter<'a>(
     }
 }
 
+/// Gets the `n`th entry of `word` or `word_eol` without decoding any other entry.
+///
+/// Returns `None` if the array has fewer than `n + 1` entries.
+///
+/// # Safety
+///
+/// `word` must be a `word` or `word_eol` pointer from HexChat.
+///
+/// `word` must be valid for the entire lifetime `'a`.
+pub(crate) unsafe fn word_nth<'a>(word: *mut *mut c_char, n: usize) -> Option<&'a CStr> {
+    // https://hexchat.readthedocs.io/en/latest/plugins.html#what-s-word-and-word-eol
+    // Safety: first index is reserved, per documentation
+    let mut word = word.add(1);
+
+    for _ in 0..n {
+        // Safety: word points to a valid null-terminated array, so we cannot read past the end or wrap
+        if (*word).is_null() {
+            return None;
+        }
+        word = word.add(1);
+    }
+
+    // Safety: word points to a valid null-terminated array
+    let elem = *word;
+    if elem.is_null() {
+        None
+    } else {
+        // Safety: word points to valid strings; words does not outlive 'a
+        Some(CStr::from_ptr::<'a>(elem))
+    }
+}
+
+/// The current element of a native `hexchat_list`, from which fields can be extracted.
+///
+/// Only `pub` so that the benchmark suite can reach it through `crate::benchmarks`;
+/// it is not part of the public API.
 #[allow(unreachable_pub)]
 #[derive(Debug)]
 pub struct ListElem<'a> {
@@ -182,8 +388,6 @@ impl<'a> ListElem<'a> {
 
 #[cfg(test)]
 mod tests {
-    use std::borrow::Cow;
-
     use super::*;
 
     fn cs(s: &str) -> &CStr {
@@ -193,14 +397,61 @@ mod tests {
     #[test]
     fn intocstr_str() {
         let owner = "hello".into_cstr();
-        assert!(matches!(owner, Cow::Owned(_)));
+        assert!(matches!(owner, CStrBuf::Scratch(_)));
         assert_eq!(owner.as_ref(), cs("hello\0"));
 
         let owner = "hello\0".into_cstr();
-        assert!(matches!(owner, Cow::Borrowed(_)));
+        assert!(matches!(owner, CStrBuf::Borrowed(_)));
         assert_eq!(owner.as_ref(), cs("hello\0"));
     }
 
+    #[test]
+    fn intocstr_str_falls_back_to_heap() {
+        // holding onto more conversions than there are scratch buffers
+        let held: Vec<_> = (0..8).map(|_| "hello".into_cstr()).collect();
+        assert!(held[..4].iter().all(|s| matches!(s, CStrBuf::Scratch(_))));
+        assert!(held[4..].iter().all(|s| matches!(s, CStrBuf::Owned(_))));
+        assert!(held.iter().all(|s| s.as_ref() == cs("hello\0")));
+        drop(held);
+
+        // the scratch buffers are returned once the conversions are dropped
+        assert!(matches!("hello".into_cstr(), CStrBuf::Scratch(_)));
+
+        // oversized strings
+        let oversized = "x".repeat(MAX_SCRATCH_LEN);
+        assert!(matches!(oversized.as_str().into_cstr(), CStrBuf::Owned(_)));
+    }
+
+    #[test]
+    fn with_cstr_array_inline() {
+        with_cstr_array(["hello", "world\0", ""], |args| {
+            assert_eq!(args[0], cs("hello\0"));
+            assert_eq!(args[1], cs("world\0"));
+            assert_eq!(args[2], cs("\0"));
+        });
+    }
+
+    #[test]
+    fn with_cstr_array_empty() {
+        assert_eq!(with_cstr_array([], |args: &[&CStr; 0]| args.len()), 0);
+    }
+
+    #[test]
+    fn with_cstr_array_spills_oversized() {
+        let oversized = "x".repeat(INLINE_ARGS_LEN);
+        with_cstr_array([oversized.as_str(), "hello"], |args| {
+            assert_eq!(args[0].to_bytes(), oversized.as_bytes());
+            // a spilled string does not consume inline space, so later args still fit
+            assert_eq!(args[1], cs("hello\0"));
+        });
+    }
+
+    #[test]
+    #[should_panic]
+    fn with_cstr_array_invalid_interior_null() {
+        with_cstr_array(["hel\0lo"], |_| ());
+    }
+
     #[test]
     #[should_panic]
     fn intocstr_str_invalid_no_null() {
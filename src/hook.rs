@@ -130,6 +130,9 @@ pub enum Timer {
 pub struct HookHandle {
     /// Always points to a valid instance of `hexchat_hook`
     handle: NonNull<hexchat_hook>,
+    /// The closure registry slot backing this hook,
+    /// for hooks registered with a closure callback (e.g. `PluginHandle::hook_command_with`).
+    closure_slot: Option<usize>,
 }
 
 impl HookHandle {
@@ -143,9 +146,21 @@ impl HookHandle {
     pub(crate) unsafe fn new(hook_handle: NonNull<hexchat_hook>) -> Self {
         Self {
             handle: hook_handle,
+            closure_slot: None,
         }
     }
 
+    /// Associates this hook with the closure registry slot backing its callback.
+    pub(crate) fn with_closure_slot(mut self, slot: usize) -> Self {
+        self.closure_slot = Some(slot);
+        self
+    }
+
+    /// Returns the closure registry slot backing this hook's callback, if any.
+    pub(crate) fn closure_slot(&self) -> Option<usize> {
+        self.closure_slot
+    }
+
     /// Converts this `HookHandle` back into a native `hexchat_hook`.
     pub(crate) fn into_raw(self) -> NonNull<hexchat_hook> {
         self.handle
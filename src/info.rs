@@ -1,5 +1,12 @@
 //! Context info.
 
+use std::any::Any;
+use std::cell::RefCell;
+use std::collections::HashMap;
+use std::fmt;
+
+use crate::plugin::PluginHandle;
+
 /// Info about the current [context](crate::PluginHandle#impl-3).
 ///
 /// Used with [`PluginHandle::get_info`](crate::PluginHandle::get_info).
@@ -72,3 +79,82 @@ macro_rules! info {
 mod impls;
 
 pub use impls::*;
+
+/// Info about the current session that cannot change until HexChat exits.
+///
+/// Values like [`ConfigDir`] and [`Version`] are fixed for the lifetime of the process,
+/// which makes them safe to cache in an [`InfoCache`];
+/// per-context values like [`Channel`] or [`Nick`] are deliberately excluded.
+///
+/// This trait is sealed and cannot be implemented outside of `hexavalent`.
+pub trait StaticInfo: Info {}
+
+impl StaticInfo for ConfigDir {}
+impl StaticInfo for LibDirFs {}
+impl StaticInfo for Version {}
+
+/// A cache over session-static info reads.
+///
+/// [`PluginHandle::get_info`](crate::PluginHandle::get_info) crosses the FFI boundary
+/// and allocates a fresh `String` on every read,
+/// even for values like [`ConfigDir`] which literally cannot change within a session.
+/// An `InfoCache` reads each such value once, then answers from memory.
+///
+/// Only [`StaticInfo`] values can be cached, so the cache never needs invalidation.
+///
+/// # Examples
+///
+/// ```rust
+/// use hexavalent::PluginHandle;
+/// use hexavalent::info::{ConfigDir, InfoCache};
+///
+/// fn log_path<P>(ph: PluginHandle<'_, P>, cache: &InfoCache) -> String {
+///     // only the first call crosses the FFI boundary
+///     format!("{}/myplugin.log", cache.get(ph, ConfigDir))
+/// }
+/// ```
+#[derive(Default)]
+pub struct InfoCache {
+    /// Map from info name (a static pointer, so usable as an identity key) to its value.
+    values: RefCell<HashMap<usize, Box<dyn Any>>>,
+}
+
+impl fmt::Debug for InfoCache {
+    fn fmt(&self, f: &mut fmt::Formatter<'_>) -> fmt::Result {
+        f.debug_struct("InfoCache")
+            .field("entries", &self.values.borrow().len())
+            .finish()
+    }
+}
+
+impl InfoCache {
+    /// Creates a new, empty `InfoCache`.
+    pub fn new() -> Self {
+        Self::default()
+    }
+
+    /// Gets session-static info, reading through to HexChat only on the first call.
+    ///
+    /// Analogous to [`PluginHandle::get_info`](crate::PluginHandle::get_info),
+    /// restricted to [`StaticInfo`] values.
+    pub fn get<P, I>(&self, ph: PluginHandle<'_, P>, info: I) -> <I as Info>::Type
+    where
+        I: StaticInfo,
+        <I as Info>::Type: Clone + 'static,
+    {
+        let key = <I as private::InfoImpl>::NAME as usize;
+
+        if let Some(value) = self.values.borrow().get(&key) {
+            let value = value
+                .downcast_ref::<<I as Info>::Type>()
+                .unwrap_or_else(|| panic!("Cached info value is an unexpected type"));
+            return value.clone();
+        }
+
+        let value = ph.get_info(info);
+        self.values
+            .borrow_mut()
+            .insert(key, Box::new(value.clone()));
+        value
+    }
+}
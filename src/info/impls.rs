@@ -24,6 +24,10 @@ info!(
 info!(Topic, "topic", Option::<String>, "Current channel topic.");
 
 // less useful ones
+info!(
+    ConfigDir,
+    "configdir", String, "HexChat configuration directory, e.g. `~/.config/hexchat`."
+);
 info!(
     Inputbox,
     "inputbox", String, "Input-box contents, what the user has typed."
@@ -33,3 +37,4 @@ info!(
     WinStatus,
     "win_status", String, "Window status: \"active\", \"hidden\" or \"normal\"."
 );
+info!(LibDirFs, "libdirfs", String, "Plugin auto-load directory.");
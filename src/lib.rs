@@ -106,19 +106,31 @@ mod macros;
 mod ffi;
 mod plugin;
 mod state;
+mod stats;
 
 #[doc(hidden)]
 pub mod internal;
 
+#[cfg(feature = "__unstable_internals_for_benchmarks")]
+#[doc(hidden)]
+pub mod benchmarks;
+
+pub mod background;
+pub mod command;
 pub mod context;
 pub mod event;
+pub mod executor;
 pub mod gui;
 pub mod hook;
 pub mod info;
 pub mod list;
+pub mod membership;
 pub mod mode;
+pub mod nick;
 pub mod pref;
+pub mod print;
 pub mod strip;
+pub mod timer;
 
 pub use plugin::{Plugin, PluginHandle};
 
@@ -1,6 +1,7 @@
 //! Info lists.
 
 use std::convert::TryFrom;
+use std::marker::PhantomData;
 use std::str::Split;
 
 /// A list that can be retrieved from HexChat.
@@ -11,12 +12,23 @@ use std::str::Split;
 /// This trait is sealed and cannot be implemented outside of `hexavalent`.
 pub trait List: private::ListImpl
 where
-    Self::Elem: private::FromListElem,
+    Self::Elem: for<'a> private::FromListElem<'a>,
+    for<'a> Self::BorrowedElem<'a>: private::FromListElem<'a>,
+    Self::SnapshotColumns: for<'a> private::SnapshotColumns<View<'a> = Self::BorrowedElem<'a>>,
 {
     /// The type of elements of the list.
-    // todo with GATs, it _might_ be nice to have Elem/BorrowedElem<'a>, so that we can avoid allocation
-    //  (but we'd probably have to make get_list_with unsafe due to invalidation of the string)
     type Elem;
+
+    /// The borrowed variant of [`Elem`](List::Elem),
+    /// where string fields are views into HexChat's own memory instead of owned copies.
+    ///
+    /// Used with [`PluginHandle::get_list_borrowed_with`](crate::PluginHandle::get_list_borrowed_with).
+    type BorrowedElem<'a>;
+
+    /// The struct-of-arrays storage type backing [`ListSnapshot`]s of this list.
+    ///
+    /// Used with [`PluginHandle::get_list_snapshot`](crate::PluginHandle::get_list_snapshot).
+    type SnapshotColumns;
 }
 
 pub(crate) mod private {
@@ -34,8 +46,22 @@ pub(crate) mod private {
     }
 
     #[allow(unreachable_pub)]
-    pub trait FromListElem: Sized {
-        fn from_list_elem(elem: ListElem<'_>) -> Self;
+    pub trait FromListElem<'a>: Sized {
+        fn from_list_elem(elem: ListElem<'a>) -> Self;
+    }
+
+    #[allow(unreachable_pub)]
+    pub trait SnapshotColumns: Default + std::fmt::Debug {
+        /// The lightweight view over one element of the snapshot.
+        type View<'a>
+        where
+            Self: 'a;
+
+        /// Appends an element to the columns, copying its string fields into `arena`.
+        fn push(&mut self, elem: ListElem<'_>, arena: &mut String);
+
+        /// Creates a view of the element at `index`, resolving string fields against `arena`.
+        fn view<'a>(&'a self, index: usize, arena: &'a str) -> Self::View<'a>;
     }
 }
 
@@ -45,7 +71,7 @@ macro_rules! list {
         $list_name:literal,
         $description:literal,
         $elem_desc:literal,
-        $elem_ty:ident {
+        $elem_ty:ident / $borrowed_ty:ident / $columns_ty:ident {
             $(
                 [ $( $field_key:literal )? $( $custom:ident )?, $field_desc:literal, $( $field_type:ident )? $( |$elem:ident| $extract:expr )? ]
                 $rust_field_name:ident : $rust_field_type:ty => $rust_method_type:ty
@@ -67,6 +93,8 @@ macro_rules! list {
 
         impl crate::list::List for $struct_name {
             type Elem = $elem_ty;
+            type BorrowedElem<'a> = $borrowed_ty<'a>;
+            type SnapshotColumns = $columns_ty;
         }
 
         #[doc = $elem_desc]
@@ -88,8 +116,8 @@ macro_rules! list {
             )*
         }
 
-        impl crate::list::private::FromListElem for $elem_ty {
-            fn from_list_elem(elem: crate::ffi::ListElem<'_>) -> Self {
+        impl<'a> crate::list::private::FromListElem<'a> for $elem_ty {
+            fn from_list_elem(elem: crate::ffi::ListElem<'a>) -> Self {
                 Self {
                     $(
                         $rust_field_name: {
@@ -100,6 +128,83 @@ macro_rules! list {
                 }
             }
         }
+
+        #[doc = $elem_desc]
+        ///
+        #[doc = concat!(
+            "Borrowed variant of [`",
+            stringify!($elem_ty),
+            "`], where string fields are views into HexChat's own memory instead of owned copies.",
+        )]
+        ///
+        /// See [`PluginHandle::get_list_borrowed_with`](crate::PluginHandle::get_list_borrowed_with) for usage.
+        #[derive(Debug, Clone)]
+        pub struct $borrowed_ty<'a> {
+            $(
+                $rust_field_name: <$rust_field_type as crate::list::BorrowListElemField>::Borrowed<'a>
+            ),*
+        }
+
+        impl<'a> $borrowed_ty<'a> {
+            $(
+                #[doc = $field_desc]
+                pub fn $rust_field_name(&self) -> <$rust_field_type as crate::list::BorrowListElemField>::Borrowed<'a> {
+                    self.$rust_field_name.clone()
+                }
+            )*
+        }
+
+        impl<'a> crate::list::private::FromListElem<'a> for $borrowed_ty<'a> {
+            fn from_list_elem(elem: crate::ffi::ListElem<'a>) -> Self {
+                Self {
+                    $(
+                        $rust_field_name: {
+                            let raw_value = list!(@generateFieldExtraction, elem, $( $field_key )? $( $custom )?, $( $field_type )? $( |$elem| $extract )?);
+                            crate::list::FromListElemField::from_list_elem_field(raw_value)
+                        }
+                    ),*
+                }
+            }
+        }
+
+        #[doc = concat!(
+            "Struct-of-arrays storage for [`ListSnapshot`](crate::list::ListSnapshot)s of [`",
+            stringify!($elem_ty),
+            "`] elements.",
+        )]
+        ///
+        /// This type must be public because it appears in [`List`](crate::list::List) impls,
+        /// but it is an implementation detail and cannot be used outside of `hexavalent`.
+        #[doc(hidden)]
+        #[derive(Debug, Default)]
+        pub struct $columns_ty {
+            $(
+                $rust_field_name: Vec<<$rust_field_type as crate::list::SnapshotListElemField>::Stored>
+            ),*
+        }
+
+        impl crate::list::private::SnapshotColumns for $columns_ty {
+            type View<'a> = $borrowed_ty<'a>
+            where
+                Self: 'a;
+
+            fn push(&mut self, elem: crate::ffi::ListElem<'_>, arena: &mut String) {
+                $(
+                    self.$rust_field_name.push({
+                        let raw_value = list!(@generateFieldExtraction, elem, $( $field_key )? $( $custom )?, $( $field_type )? $( |$elem| $extract )?);
+                        <$rust_field_type as crate::list::StoreListElemField<_>>::store_list_elem_field(raw_value, arena)
+                    });
+                )*
+            }
+
+            fn view<'a>(&'a self, index: usize, arena: &'a str) -> $borrowed_ty<'a> {
+                $borrowed_ty {
+                    $(
+                        $rust_field_name: <$rust_field_type as crate::list::SnapshotListElemField>::load_list_elem_field(self.$rust_field_name[index], arena)
+                    ),*
+                }
+            }
+        }
     };
 
     (
@@ -124,8 +229,81 @@ macro_rules! list {
     }
 }
 
+/// Owned storage for a comma-separated list field.
+///
+/// This type must be public because it appears in borrowed elements' method signatures,
+/// but it is an implementation detail and cannot be used outside of `hexavalent`.
+#[doc(hidden)]
+#[derive(Debug, Clone)]
+pub struct SplitByCommas(String);
+
+/// Iterator over the comma-separated entries of a borrowed list field.
+///
+/// Returned by borrowed list elements such as [`NotifyRef::networks`](crate::list::NotifyRef::networks).
 #[derive(Debug, Clone)]
-struct SplitByCommas(String);
+pub struct CommaSeparated<'a>(Split<'a, char>);
+
+impl<'a> Iterator for CommaSeparated<'a> {
+    type Item = &'a str;
+
+    fn next(&mut self) -> Option<Self::Item> {
+        self.0.next()
+    }
+}
+
+/// Maps a field storage type to its borrowed counterpart,
+/// used to derive the borrowed variant of each list element type.
+///
+/// This trait must be public because it appears in borrowed elements' method signatures,
+/// but it is an implementation detail and cannot be used outside of `hexavalent`.
+#[doc(hidden)]
+pub trait BorrowListElemField {
+    /// The borrowed counterpart of this field storage type.
+    type Borrowed<'a>: Clone + std::fmt::Debug;
+}
+
+impl BorrowListElemField for String {
+    type Borrowed<'a> = &'a str;
+}
+
+impl BorrowListElemField for Option<String> {
+    type Borrowed<'a> = Option<&'a str>;
+}
+
+impl BorrowListElemField for SplitByCommas {
+    type Borrowed<'a> = CommaSeparated<'a>;
+}
+
+/// Implements `BorrowListElemField` and `SnapshotListElemField` for `Copy` field types,
+/// which are not borrowed at all and are stored inline in snapshots.
+macro_rules! borrow_list_elem_field_by_copy {
+    ($($ty:ty),* $(,)?) => {
+        $(
+            impl crate::list::BorrowListElemField for $ty {
+                type Borrowed<'a> = $ty;
+            }
+
+            impl crate::list::SnapshotListElemField for $ty {
+                type Stored = $ty;
+
+                fn load_list_elem_field(stored: $ty, _arena: &str) -> $ty {
+                    stored
+                }
+            }
+
+            impl<Raw> crate::list::StoreListElemField<Raw> for $ty
+            where
+                $ty: crate::list::FromListElemField<Raw>,
+            {
+                fn store_list_elem_field(raw: Raw, _arena: &mut String) -> $ty {
+                    crate::list::FromListElemField::from_list_elem_field(raw)
+                }
+            }
+        )*
+    };
+}
+
+borrow_list_elem_field_by_copy!(i32, u32, u64, bool, Option<char>);
 
 trait FromListElemField<T> {
     fn from_list_elem_field(field: T) -> Self;
@@ -186,6 +364,18 @@ impl FromListElemField<Option<&str>> for SplitByCommas {
     }
 }
 
+impl<'a> FromListElemField<Option<&'a str>> for &'a str {
+    fn from_list_elem_field(field: Option<&'a str>) -> Self {
+        field.unwrap_or_else(|| panic!("Unexpected null string in list"))
+    }
+}
+
+impl<'a> FromListElemField<Option<&'a str>> for CommaSeparated<'a> {
+    fn from_list_elem_field(field: Option<&'a str>) -> Self {
+        Self(field.unwrap_or_default().split(','))
+    }
+}
+
 trait ProjectListElemField<'a, T> {
     fn project_list_elem_field(&'a self) -> T;
 }
@@ -214,6 +404,379 @@ impl<'a> ProjectListElemField<'a, Split<'a, char>> for SplitByCommas {
     }
 }
 
+/// A byte range into a [`ListSnapshot`]'s string arena.
+#[derive(Debug, Copy, Clone)]
+struct StrSpan {
+    start: u32,
+    end: u32,
+}
+
+impl StrSpan {
+    fn get(self, arena: &str) -> &str {
+        &arena[self.start as usize..self.end as usize]
+    }
+}
+
+/// Copies `s` to the end of `arena`, returning its location.
+fn push_to_arena(arena: &mut String, s: &str) -> StrSpan {
+    let start = u32::try_from(arena.len())
+        .unwrap_or_else(|e| panic!("List snapshot arena too large: {}", e));
+    arena.push_str(s);
+    let end = u32::try_from(arena.len())
+        .unwrap_or_else(|e| panic!("List snapshot arena too large: {}", e));
+    StrSpan { start, end }
+}
+
+/// Maps a field storage type to its compact arena-relative representation in snapshots,
+/// used to derive the struct-of-arrays storage of each list.
+trait SnapshotListElemField: BorrowListElemField {
+    /// The compact representation of this field, stored inline in a snapshot column.
+    type Stored: Copy + std::fmt::Debug;
+
+    /// Resolves a stored field against the snapshot's string arena.
+    fn load_list_elem_field(stored: Self::Stored, arena: &str) -> Self::Borrowed<'_>;
+}
+
+trait StoreListElemField<Raw>: SnapshotListElemField {
+    /// Converts a raw field value to its compact representation,
+    /// copying string contents into `arena`.
+    fn store_list_elem_field(raw: Raw, arena: &mut String) -> Self::Stored;
+}
+
+impl SnapshotListElemField for String {
+    type Stored = StrSpan;
+
+    fn load_list_elem_field(stored: StrSpan, arena: &str) -> &str {
+        stored.get(arena)
+    }
+}
+
+impl StoreListElemField<Option<&str>> for String {
+    fn store_list_elem_field(raw: Option<&str>, arena: &mut String) -> StrSpan {
+        let raw = raw.unwrap_or_else(|| panic!("Unexpected null string in list"));
+        push_to_arena(arena, raw)
+    }
+}
+
+impl SnapshotListElemField for Option<String> {
+    type Stored = Option<StrSpan>;
+
+    fn load_list_elem_field(stored: Option<StrSpan>, arena: &str) -> Option<&str> {
+        stored.map(|span| span.get(arena))
+    }
+}
+
+impl StoreListElemField<Option<&str>> for Option<String> {
+    fn store_list_elem_field(raw: Option<&str>, arena: &mut String) -> Option<StrSpan> {
+        raw.map(|raw| push_to_arena(arena, raw))
+    }
+}
+
+impl SnapshotListElemField for SplitByCommas {
+    type Stored = StrSpan;
+
+    fn load_list_elem_field(stored: StrSpan, arena: &str) -> CommaSeparated<'_> {
+        CommaSeparated(stored.get(arena).split(','))
+    }
+}
+
+impl StoreListElemField<Option<&str>> for SplitByCommas {
+    fn store_list_elem_field(raw: Option<&str>, arena: &mut String) -> StrSpan {
+        push_to_arena(arena, raw.unwrap_or_default())
+    }
+}
+
+/// An owned snapshot of a list, with all elements stored contiguously.
+///
+/// Returned by [`PluginHandle::get_list_snapshot`](crate::PluginHandle::get_list_snapshot).
+///
+/// String fields are copied into one contiguous arena and all fields are stored struct-of-arrays,
+/// so creating a snapshot performs a handful of allocations regardless of the number of elements,
+/// and scanning it is cache-friendly.
+/// Elements are exposed as the list's borrowed element type, e.g. [`ChannelRef`],
+/// whose string fields are views into the arena.
+pub struct ListSnapshot<L: List> {
+    arena: String,
+    columns: L::SnapshotColumns,
+    len: usize,
+}
+
+impl<L: List> ListSnapshot<L> {
+    pub(crate) fn new() -> Self {
+        Self {
+            arena: String::new(),
+            columns: Default::default(),
+            len: 0,
+        }
+    }
+
+    pub(crate) fn push(&mut self, elem: crate::ffi::ListElem<'_>) {
+        private::SnapshotColumns::push(&mut self.columns, elem, &mut self.arena);
+        self.len += 1;
+    }
+
+    /// The number of elements in the snapshot.
+    ///
+    /// # Examples
+    ///
+    /// ```rust
+    /// use hexavalent::PluginHandle;
+    /// use hexavalent::list::Channels;
+    ///
+    /// fn count_channels<P>(ph: PluginHandle<'_, P>) -> usize {
+    ///     ph.get_list_snapshot(Channels)
+    ///         .map(|channels| channels.len())
+    ///         .unwrap_or(0)
+    /// }
+    /// ```
+    pub fn len(&self) -> usize {
+        self.len
+    }
+
+    /// Whether the snapshot contains no elements.
+    ///
+    /// # Examples
+    ///
+    /// ```rust
+    /// use hexavalent::{PluginHandle, list::ListSnapshot, list::Users};
+    ///
+    /// fn alone(users: &ListSnapshot<Users>) -> bool {
+    ///     users.is_empty()
+    /// }
+    /// ```
+    pub fn is_empty(&self) -> bool {
+        self.len == 0
+    }
+
+    /// Gets a view of the element at `index`.
+    ///
+    /// # Panics
+    ///
+    /// If `index` is not less than the snapshot's length.
+    ///
+    /// # Examples
+    ///
+    /// ```rust
+    /// use hexavalent::{PluginHandle, list::ListSnapshot, list::Users};
+    ///
+    /// fn first_nick(users: &ListSnapshot<Users>) -> Option<&str> {
+    ///     if users.is_empty() {
+    ///         return None;
+    ///     }
+    ///     Some(users.get(0).nick())
+    /// }
+    /// ```
+    pub fn get(&self, index: usize) -> <L as List>::BorrowedElem<'_> {
+        assert!(
+            index < self.len,
+            "Index {} out of range for list snapshot of {} elements",
+            index,
+            self.len,
+        );
+
+        private::SnapshotColumns::view(&self.columns, index, &self.arena)
+    }
+
+    /// Iterates over views of the snapshot's elements.
+    ///
+    /// # Examples
+    ///
+    /// ```rust
+    /// use hexavalent::{PluginHandle, list::ListSnapshot, list::Channels};
+    ///
+    /// fn total_users(channels: &ListSnapshot<Channels>) -> u32 {
+    ///     channels.iter().map(|channel| channel.num_users()).sum()
+    /// }
+    /// ```
+    pub fn iter(&self) -> impl Iterator<Item = <L as List>::BorrowedElem<'_>> {
+        (0..self.len)
+            .map(move |index| private::SnapshotColumns::view(&self.columns, index, &self.arena))
+    }
+}
+
+impl<L: List> std::fmt::Debug for ListSnapshot<L> {
+    fn fmt(&self, f: &mut std::fmt::Formatter<'_>) -> std::fmt::Result {
+        f.debug_struct("ListSnapshot")
+            .field("columns", &self.columns)
+            .field("len", &self.len)
+            .finish_non_exhaustive()
+    }
+}
+
+/// A stream over a list's elements, freeing the underlying list when dropped.
+///
+/// Returned by [`PluginHandle::get_list_stream`](crate::PluginHandle::get_list_stream).
+///
+/// [`next_borrowed`](Self::next_borrowed) lends out borrowed elements
+/// whose string fields are views into HexChat's own memory,
+/// with static dispatch for each element step.
+/// Alternatively, the stream is an [`Iterator`] over owned elements
+/// with an exact [`size_hint`](Iterator::size_hint),
+/// so collecting it allocates once instead of regrowing.
+///
+/// Avoid calling functions which could invalidate the list while the stream is live,
+/// e.g. running commands that close channels or disconnect users.
+pub struct ListStream<'ph, L: List> {
+    /// Always points to a valid instance of `hexchat_plugin`.
+    handle: *mut crate::ffi::hexchat_plugin,
+    /// Always points to a valid list, owned (and freed) by this stream.
+    list: *mut crate::ffi::hexchat_list,
+    /// The number of elements not yet yielded.
+    remaining: usize,
+    _lifetime: PhantomData<&'ph crate::ffi::hexchat_plugin>,
+    _list_type: PhantomData<L>,
+}
+
+impl<'ph, L: List> ListStream<'ph, L> {
+    /// Creates a stream owning a list.
+    ///
+    /// # Safety
+    ///
+    /// `handle` must point to a `hexchat_plugin` which is valid for the entire lifetime `'ph`.
+    ///
+    /// `list` must have been returned by `hexchat_list_get`, not yet be freed or traversed,
+    /// hold exactly `remaining` elements, and not be used again after this call.
+    pub(crate) unsafe fn new(
+        handle: *mut crate::ffi::hexchat_plugin,
+        list: *mut crate::ffi::hexchat_list,
+        remaining: usize,
+    ) -> Self {
+        Self {
+            handle,
+            list,
+            remaining,
+            _lifetime: PhantomData,
+            _list_type: PhantomData,
+        }
+    }
+
+    /// Advances the stream, lending a borrowed view of the next element.
+    ///
+    /// Behaves like [`Iterator::next`], but the element's string fields
+    /// are views into HexChat's own memory instead of owned copies,
+    /// so stepping through the list copies nothing.
+    ///
+    /// # Examples
+    ///
+    /// ```rust
+    /// use hexavalent::PluginHandle;
+    /// use hexavalent::list::Users;
+    ///
+    /// fn print_users<P>(ph: PluginHandle<'_, P>) -> Result<(), ()> {
+    ///     let mut users = ph.get_list_stream(Users)?;
+    ///     while let Some(user) = users.next_borrowed() {
+    ///         ph.print(&format!("{}\0", user.nick()));
+    ///     }
+    ///     Ok(())
+    /// }
+    /// ```
+    pub fn next_borrowed(&mut self) -> Option<<L as List>::BorrowedElem<'_>> {
+        // Safety: handle is always valid; list is valid until freed in drop
+        // Safety: hexchat_list_next can safely be called multiple times at the end of a list
+        if unsafe { ((*self.handle).hexchat_list_next)(self.handle, self.list) } == 0 {
+            self.remaining = 0;
+            return None;
+        }
+
+        self.remaining = self.remaining.saturating_sub(1);
+
+        // Safety: handle/list are valid until the list is freed, and hexchat_list_next returned true
+        let elem = unsafe { crate::ffi::ListElem::new(&self.handle, &self.list) };
+
+        Some(private::FromListElem::from_list_elem(elem))
+    }
+}
+
+impl<'ph, L: List> Iterator for ListStream<'ph, L> {
+    type Item = <L as List>::Elem;
+
+    fn next(&mut self) -> Option<Self::Item> {
+        // Safety: handle is always valid; list is valid until freed in drop
+        // Safety: hexchat_list_next can safely be called multiple times at the end of a list
+        if unsafe { ((*self.handle).hexchat_list_next)(self.handle, self.list) } == 0 {
+            self.remaining = 0;
+            return None;
+        }
+
+        self.remaining = self.remaining.saturating_sub(1);
+
+        // Safety: handle/list are valid until the list is freed, and hexchat_list_next returned true
+        let elem = unsafe { crate::ffi::ListElem::new(&self.handle, &self.list) };
+
+        Some(private::FromListElem::from_list_elem(elem))
+    }
+
+    fn size_hint(&self) -> (usize, Option<usize>) {
+        (self.remaining, Some(self.remaining))
+    }
+}
+
+impl<'ph, L: List> ExactSizeIterator for ListStream<'ph, L> {}
+
+impl<'ph, L: List> std::iter::FusedIterator for ListStream<'ph, L> {}
+
+impl<'ph, L: List> std::fmt::Debug for ListStream<'ph, L> {
+    fn fmt(&self, f: &mut std::fmt::Formatter<'_>) -> std::fmt::Result {
+        f.debug_struct("ListStream")
+            .field("remaining", &self.remaining)
+            .finish_non_exhaustive()
+    }
+}
+
+impl<'ph, L: List> Drop for ListStream<'ph, L> {
+    fn drop(&mut self) {
+        // Safety: handle is always valid; list was returned by hexchat_list_get and is freed only here
+        unsafe { ((*self.handle).hexchat_list_free)(self.handle, self.list) }
+    }
+}
+
 mod impls;
 
 pub use impls::*;
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn arena_spans_round_trip() {
+        let mut arena = String::new();
+
+        let hello = push_to_arena(&mut arena, "hello");
+        let empty = push_to_arena(&mut arena, "");
+        let world = push_to_arena(&mut arena, "world");
+
+        assert_eq!(hello.get(&arena), "hello");
+        assert_eq!(empty.get(&arena), "");
+        assert_eq!(world.get(&arena), "world");
+        assert_eq!(arena, "helloworld");
+    }
+
+    #[test]
+    fn string_fields_store_into_arena() {
+        let mut arena = String::new();
+
+        let nick =
+            <String as StoreListElemField<_>>::store_list_elem_field(Some("nick"), &mut arena);
+        let account =
+            <Option<String> as StoreListElemField<_>>::store_list_elem_field(None, &mut arena);
+        let networks = <SplitByCommas as StoreListElemField<_>>::store_list_elem_field(
+            Some("freenode,libera"),
+            &mut arena,
+        );
+
+        assert_eq!(
+            <String as SnapshotListElemField>::load_list_elem_field(nick, &arena),
+            "nick"
+        );
+        assert_eq!(
+            <Option<String> as SnapshotListElemField>::load_list_elem_field(account, &arena),
+            None
+        );
+        assert_eq!(
+            <SplitByCommas as SnapshotListElemField>::load_list_elem_field(networks, &arena)
+                .collect::<Vec<_>>(),
+            ["freenode", "libera"]
+        );
+    }
+}
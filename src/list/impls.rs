@@ -4,12 +4,22 @@ use std::num::NonZeroU64;
 use bitflags::bitflags;
 use time::OffsetDateTime;
 
+borrow_list_elem_field_by_copy!(
+    ChannelFlags,
+    ChannelType,
+    IgnoreFlags,
+    NotifyFlags,
+    OffsetDateTime,
+    SocketAddrV4,
+    Option<NonZeroU64>,
+);
+
 list!(
     Channels,
     "channels",
     "List of channels, queries and their servers.",
     "A channel.",
-    Channel {
+    Channel / ChannelRef / ChannelColumns {
         ["channel", "Channel or query name.", string] name: String => &str,
         ["channelkey", "Channel key. (HexChat 2.9.6+)", string] key: Option<String> => Option<&str>,
         ["chanmodes", "Available channel modes e.g. `\"beI,k,l\"`. (HexChat 2.12.2+)", string] modes: String => &str,
@@ -112,7 +122,7 @@ list!(
     "dcc",
     "List of DCC file transfers.",
     "A DCC file transfer.",
-    DccTransfer {
+    DccTransfer / DccTransferRef / DccTransferColumns {
         [
             custom,
             "Socket of the remote user.",
@@ -145,7 +155,7 @@ list!(
     "ignore",
     "List of ignores.",
     "An ignored mask.",
-    Ignore {
+    Ignore / IgnoreRef / IgnoreColumns {
         ["mask", "Ignore mask, e.g. `\"*!*@*.aol.com\"`.", string] mask: String => &str,
         ["flags", "Info flags.", int] flags: IgnoreFlags => IgnoreFlags,
     }
@@ -187,7 +197,7 @@ list!(
     "notify",
     "List of people on notify in the current server [context](crate::PluginHandle#impl-3).",
     "A nick on notify.",
-    Notify {
+    Notify / NotifyRef / NotifyColumns {
         ["networks", "Networks to which this nick applies.", string] networks: super::SplitByCommas => impl Iterator<Item = &str>,
         ["nick", "Nickname.", string] nick: String => &str,
         ["flags", "Info flags.", int] flags: NotifyFlags => NotifyFlags,
@@ -219,7 +229,7 @@ list!(
     "users",
     "List of users in the current [context](crate::PluginHandle#impl-3).",
     "A user.",
-    User {
+    User / UserRef / UserColumns {
         ["account", "Account name. (HexChat 2.9.6+)", string] account: Option<String> => Option<&str>,
         ["away", "Away status.", int] is_away: bool => bool,
         ["lasttalk", "Last time the user was seen talking.", time] last_talk: OffsetDateTime => OffsetDateTime,
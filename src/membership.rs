@@ -0,0 +1,712 @@
+//! Channel membership tracking.
+
+use std::cell::RefCell;
+use std::collections::HashMap;
+use std::mem;
+use std::time::Duration;
+
+use crate::context::Context;
+use crate::event::server::{Join, Kick, Mode, Nick, Part, Quit};
+use crate::event::Event;
+use crate::hook::{Eat, Priority, Timer};
+use crate::list::Users;
+use crate::nick::casefold_byte;
+use crate::plugin::PluginHandle;
+
+/// Folds a nickname or channel name to its RFC1459 lowercase form, for use as a map key.
+fn casefold(str: &str) -> String {
+    str.chars()
+        .map(|c| {
+            if c.is_ascii() {
+                char::from(casefold_byte(c as u8))
+            } else {
+                c
+            }
+        })
+        .collect()
+}
+
+/// Extracts the nickname from a server event's sender field, e.g. `":nick!user@host"`.
+fn sender_nick(sender: &str) -> &str {
+    let sender = strip_leading_colon(sender);
+    sender.split('!').next().unwrap_or(sender)
+}
+
+/// Strips the leading `:` from a trailing server event parameter, e.g. `":#channel"`.
+fn strip_leading_colon(param: &str) -> &str {
+    param.strip_prefix(':').unwrap_or(param)
+}
+
+/// Ranks nickname prefixes so that higher-privilege prefixes are not overwritten by lower ones.
+fn prefix_rank(prefix: Option<char>) -> u8 {
+    match prefix {
+        Some('@') => 3,
+        Some('%') => 2,
+        Some('+') => 1,
+        _ => 0,
+    }
+}
+
+/// A user recorded in a [`UserIndex`].
+#[derive(Debug, Clone)]
+pub struct UserEntry {
+    nick: String,
+    prefix: Option<char>,
+    account: Option<String>,
+}
+
+impl UserEntry {
+    /// Nickname, in its original case.
+    pub fn nick(&self) -> &str {
+        &self.nick
+    }
+
+    /// Prefix character e.g. `'@'` or `'+'`.
+    pub fn prefix(&self) -> Option<char> {
+        self.prefix
+    }
+
+    /// Account name, if known.
+    pub fn account(&self) -> Option<&str> {
+        self.account.as_deref()
+    }
+}
+
+/// An incrementally-maintained index of the users in each channel.
+///
+/// Answering "is nick X in channel Y" with [`PluginHandle::get_list`](crate::PluginHandle::get_list)
+/// traverses the entire user list across the FFI boundary and copies every field on every query.
+/// A `UserIndex` instead takes one [`Users`](crate::list::Users) snapshot per channel,
+/// then keeps it current by applying `JOIN`/`PART`/`QUIT`/`NICK`/`KICK`/`MODE` server events,
+/// so steady-state lookups are a single hash probe.
+///
+/// To use it, store a `UserIndex` in your plugin, implement `AsRef<UserIndex>`,
+/// and call [`PluginHandle::hook_user_index`] in [`Plugin::init`](crate::Plugin::init).
+/// See [`PluginHandle::hook_user_index`] for an example.
+///
+/// Nicknames and channel names are matched per RFC1459, as with [`nick::nickcmp`](crate::nick::nickcmp).
+///
+/// Mode tracking is best-effort: it understands the conventional `+o`/`+h`/`+v` prefixes,
+/// but a user holding several prefix modes at once is only indexed under the highest.
+/// Call [`UserIndex::refresh`] if you need an exact snapshot.
+#[derive(Debug, Default)]
+pub struct UserIndex {
+    /// Map from folded channel name to a map from folded nick to user.
+    channels: RefCell<HashMap<String, HashMap<String, UserEntry>>>,
+}
+
+impl UserIndex {
+    /// Creates a new, empty `UserIndex`.
+    pub fn new() -> Self {
+        Self::default()
+    }
+
+    /// Looks up a user by channel and nickname.
+    ///
+    /// The first lookup in an untracked channel takes a full [`Users`](crate::list::Users) snapshot;
+    /// subsequent lookups in that channel are hash probes with no FFI call.
+    ///
+    /// Returns `None` if the user is not in the channel, or if the channel cannot be found.
+    pub fn lookup<P>(
+        &self,
+        ph: PluginHandle<'_, P>,
+        channel: &str,
+        nick: &str,
+    ) -> Option<UserEntry> {
+        let channel_key = casefold(channel);
+
+        if !self.channels.borrow().contains_key(&channel_key) {
+            self.refresh(ph, channel).ok()?;
+        }
+
+        self.channels
+            .borrow()
+            .get(&channel_key)
+            .and_then(|users| users.get(&casefold(nick)))
+            .cloned()
+    }
+
+    /// Replaces the index for a channel with a fresh [`Users`](crate::list::Users) snapshot.
+    ///
+    /// Fails if the channel cannot be found, or if the user list cannot be retrieved.
+    pub fn refresh<P>(&self, ph: PluginHandle<'_, P>, channel: &str) -> Result<(), ()> {
+        let ctxt = ph.find_context(Context::Nearby { channel }).ok_or(())?;
+
+        let mut users = HashMap::new();
+        ph.with_context(ctxt, || {
+            ph.get_list_borrowed_with(Users, |user| {
+                users.insert(
+                    casefold(user.nick()),
+                    UserEntry {
+                        nick: user.nick().to_owned(),
+                        prefix: user.prefix(),
+                        account: user.account().map(ToOwned::to_owned),
+                    },
+                );
+            })
+        })?;
+
+        self.channels.borrow_mut().insert(casefold(channel), users);
+        Ok(())
+    }
+
+    /// Discards all tracked channels.
+    ///
+    /// Future lookups will take fresh snapshots, as if the index were newly created.
+    pub fn clear(&self) {
+        self.channels.borrow_mut().clear();
+    }
+
+    fn on_join(&self, channel: &str, nick: &str, account: &str) {
+        if let Some(users) = self.channels.borrow_mut().get_mut(&casefold(channel)) {
+            users.insert(
+                casefold(nick),
+                UserEntry {
+                    nick: nick.to_owned(),
+                    prefix: None,
+                    account: match account {
+                        "" | "*" => None,
+                        account => Some(account.to_owned()),
+                    },
+                },
+            );
+        }
+    }
+
+    fn on_leave(&self, channel: &str, nick: &str) {
+        if let Some(users) = self.channels.borrow_mut().get_mut(&casefold(channel)) {
+            users.remove(&casefold(nick));
+        }
+    }
+
+    fn on_quit(&self, nick: &str) {
+        let nick_key = casefold(nick);
+        for users in self.channels.borrow_mut().values_mut() {
+            users.remove(&nick_key);
+        }
+    }
+
+    fn on_nick(&self, old_nick: &str, new_nick: &str) {
+        let old_key = casefold(old_nick);
+        for users in self.channels.borrow_mut().values_mut() {
+            if let Some(mut entry) = users.remove(&old_key) {
+                entry.nick = new_nick.to_owned();
+                users.insert(casefold(new_nick), entry);
+            }
+        }
+    }
+
+    fn on_mode(&self, channel: &str, modes: &str, mode_args: &str) {
+        let mut channels = self.channels.borrow_mut();
+        let users = match channels.get_mut(&casefold(channel)) {
+            Some(users) => users,
+            None => return,
+        };
+
+        let mut args = mode_args.split(' ').filter(|a| !a.is_empty());
+        let mut adding = true;
+        for mode in modes.chars() {
+            match mode {
+                '+' => adding = true,
+                '-' => adding = false,
+                'o' | 'h' | 'v' => {
+                    let target = match args.next() {
+                        Some(target) => target,
+                        None => break,
+                    };
+                    let prefix = match mode {
+                        'o' => '@',
+                        'h' => '%',
+                        _ => '+',
+                    };
+                    if let Some(entry) = users.get_mut(&casefold(target)) {
+                        if adding {
+                            if prefix_rank(Some(prefix)) > prefix_rank(entry.prefix) {
+                                entry.prefix = Some(prefix);
+                            }
+                        } else if entry.prefix == Some(prefix) {
+                            entry.prefix = None;
+                        }
+                    }
+                }
+                // these modes take an argument, which must not be mistaken for a prefix target
+                'b' | 'q' | 'e' | 'I' | 'k' => {
+                    let _ = args.next();
+                }
+                'l' if adding => {
+                    let _ = args.next();
+                }
+                _ => {}
+            }
+        }
+    }
+}
+
+/// Channel Membership
+///
+/// Maintains a [`UserIndex`] from server events.
+impl<'ph, P: 'static + AsRef<UserIndex>> PluginHandle<'ph, P> {
+    /// Registers the server event hooks which keep a [`UserIndex`] current.
+    ///
+    /// Call this once from [`Plugin::init`](crate::Plugin::init).
+    /// The registered hooks do not eat any events.
+    ///
+    /// # Examples
+    ///
+    /// ```rust
+    /// use hexavalent::{Plugin, PluginHandle};
+    /// use hexavalent::membership::UserIndex;
+    ///
+    /// #[derive(Default)]
+    /// struct MyPlugin {
+    ///     users: UserIndex,
+    /// }
+    ///
+    /// impl AsRef<UserIndex> for MyPlugin {
+    ///     fn as_ref(&self) -> &UserIndex {
+    ///         &self.users
+    ///     }
+    /// }
+    ///
+    /// impl Plugin for MyPlugin {
+    ///     fn init(&self, ph: PluginHandle<'_, Self>) {
+    ///         ph.hook_user_index();
+    ///     }
+    /// }
+    ///
+    /// fn is_op(plugin: &MyPlugin, ph: PluginHandle<'_, MyPlugin>, channel: &str, nick: &str) -> bool {
+    ///     plugin.users.lookup(ph, channel, nick)
+    ///         .map_or(false, |user| user.prefix() == Some('@'))
+    /// }
+    /// ```
+    pub fn hook_user_index(self) {
+        fn join_cb<P: 'static + AsRef<UserIndex>>(
+            plugin: &P,
+            _ph: PluginHandle<'_, P>,
+            args: <Join as Event<'_>>::Args,
+        ) -> Eat {
+            let [sender, _, channel, account, _realname] = args;
+            plugin.as_ref().on_join(
+                strip_leading_colon(channel),
+                sender_nick(sender),
+                strip_leading_colon(account),
+            );
+            Eat::None
+        }
+
+        fn part_cb<P: 'static + AsRef<UserIndex>>(
+            plugin: &P,
+            _ph: PluginHandle<'_, P>,
+            args: <Part as Event<'_>>::Args,
+        ) -> Eat {
+            let [sender, _, channel, _reason] = args;
+            plugin
+                .as_ref()
+                .on_leave(strip_leading_colon(channel), sender_nick(sender));
+            Eat::None
+        }
+
+        fn quit_cb<P: 'static + AsRef<UserIndex>>(
+            plugin: &P,
+            _ph: PluginHandle<'_, P>,
+            args: <Quit as Event<'_>>::Args,
+        ) -> Eat {
+            let [sender, _, _reason] = args;
+            plugin.as_ref().on_quit(sender_nick(sender));
+            Eat::None
+        }
+
+        fn nick_cb<P: 'static + AsRef<UserIndex>>(
+            plugin: &P,
+            _ph: PluginHandle<'_, P>,
+            args: <Nick as Event<'_>>::Args,
+        ) -> Eat {
+            let [sender, _, new_nick] = args;
+            plugin
+                .as_ref()
+                .on_nick(sender_nick(sender), strip_leading_colon(new_nick));
+            Eat::None
+        }
+
+        fn kick_cb<P: 'static + AsRef<UserIndex>>(
+            plugin: &P,
+            _ph: PluginHandle<'_, P>,
+            args: <Kick as Event<'_>>::Args,
+        ) -> Eat {
+            let [_sender, _, channel, target, _reason] = args;
+            plugin
+                .as_ref()
+                .on_leave(strip_leading_colon(channel), target);
+            Eat::None
+        }
+
+        fn mode_cb<P: 'static + AsRef<UserIndex>>(
+            plugin: &P,
+            _ph: PluginHandle<'_, P>,
+            args: <Mode as Event<'_>>::Args,
+        ) -> Eat {
+            let [_sender, _, target, modes, mode_args] = args;
+            plugin
+                .as_ref()
+                .on_mode(target, modes, strip_leading_colon(mode_args));
+            Eat::None
+        }
+
+        self.hook_server(Join, Priority::Normal, join_cb);
+        self.hook_server(Part, Priority::Normal, part_cb);
+        self.hook_server(Quit, Priority::Normal, quit_cb);
+        self.hook_server(Nick, Priority::Normal, nick_cb);
+        self.hook_server(Kick, Priority::Normal, kick_cb);
+        self.hook_server(Mode, Priority::Normal, mode_cb);
+    }
+}
+
+/// A single channel membership change, recorded by a [`MembershipStream`].
+#[derive(Debug, Clone)]
+#[non_exhaustive]
+pub enum MembershipDelta {
+    /// A user joined a channel.
+    Join {
+        /// The channel that was joined.
+        channel: String,
+        /// The nickname of the user who joined.
+        nick: String,
+    },
+    /// A user left a channel, either by parting or by being kicked.
+    Part {
+        /// The channel that was left.
+        channel: String,
+        /// The nickname of the user who left.
+        nick: String,
+    },
+    /// A user disconnected from the server, leaving every channel.
+    Quit {
+        /// The nickname of the user who quit.
+        nick: String,
+    },
+    /// A user changed their nickname, in every channel.
+    Nick {
+        /// The previous nickname.
+        old_nick: String,
+        /// The new nickname.
+        new_nick: String,
+    },
+    /// Channel modes changed.
+    Mode {
+        /// The channel whose modes changed.
+        channel: String,
+        /// The mode string, e.g. `"+o-v"`.
+        modes: String,
+        /// The mode arguments, e.g. `"alice bob"`.
+        args: String,
+    },
+}
+
+/// A batched stream of channel membership changes.
+///
+/// Observing membership change over time with [`PluginHandle::get_list`](crate::PluginHandle::get_list)
+/// means polling the entire user list and diffing it,
+/// an O(users) FFI traversal plus allocation on every poll.
+/// A `MembershipStream` instead assembles compact [`MembershipDelta`] values
+/// from `JOIN`/`PART`/`QUIT`/`NICK`/`KICK`/`MODE` server events as they arrive,
+/// and delivers all deltas accumulated since the last tick in one batch,
+/// driven by a single HexChat timer.
+///
+/// To use it, store a `MembershipStream` in your plugin, implement `AsRef<MembershipStream>`,
+/// and call [`PluginHandle::hook_membership_stream`] in [`Plugin::init`](crate::Plugin::init).
+/// See [`PluginHandle::hook_membership_stream`] for an example.
+#[derive(Debug, Default)]
+pub struct MembershipStream {
+    /// Deltas accumulated since the last delivery.
+    pending: RefCell<Vec<MembershipDelta>>,
+}
+
+impl MembershipStream {
+    /// Creates a new, empty `MembershipStream`.
+    pub fn new() -> Self {
+        Self::default()
+    }
+
+    fn record(&self, delta: MembershipDelta) {
+        self.pending.borrow_mut().push(delta);
+    }
+
+    fn take_pending(&self) -> Vec<MembershipDelta> {
+        mem::take(&mut *self.pending.borrow_mut())
+    }
+}
+
+/// Membership Deltas
+///
+/// Assembles a [`MembershipStream`] from server events.
+impl<'ph, P: 'static + AsRef<MembershipStream>> PluginHandle<'ph, P> {
+    /// Registers the hooks which assemble and deliver a [`MembershipStream`].
+    ///
+    /// Call this once from [`Plugin::init`](crate::Plugin::init).
+    /// The registered hooks do not eat any events.
+    ///
+    /// `on_deltas` is invoked at most once per `resolution`,
+    /// with every [`MembershipDelta`] recorded since its previous invocation;
+    /// ticks with no recorded deltas do not invoke it at all.
+    ///
+    /// # Examples
+    ///
+    /// ```rust
+    /// use std::time::Duration;
+    /// use hexavalent::{Plugin, PluginHandle};
+    /// use hexavalent::membership::{MembershipDelta, MembershipStream};
+    ///
+    /// #[derive(Default)]
+    /// struct MyPlugin {
+    ///     deltas: MembershipStream,
+    /// }
+    ///
+    /// impl AsRef<MembershipStream> for MyPlugin {
+    ///     fn as_ref(&self) -> &MembershipStream {
+    ///         &self.deltas
+    ///     }
+    /// }
+    ///
+    /// impl Plugin for MyPlugin {
+    ///     fn init(&self, ph: PluginHandle<'_, Self>) {
+    ///         ph.hook_membership_stream(Duration::from_millis(250), |plugin, ph, deltas| {
+    ///             for delta in deltas {
+    ///                 if let MembershipDelta::Join { channel, nick } = delta {
+    ///                     ph.print(&format!("{} joined {}\0", nick, channel));
+    ///                 }
+    ///             }
+    ///         });
+    ///     }
+    /// }
+    /// ```
+    pub fn hook_membership_stream(
+        self,
+        resolution: Duration,
+        on_deltas: fn(plugin: &P, ph: PluginHandle<'_, P>, deltas: &[MembershipDelta]),
+    ) {
+        fn join_cb<P: 'static + AsRef<MembershipStream>>(
+            plugin: &P,
+            _ph: PluginHandle<'_, P>,
+            args: <Join as Event<'_>>::Args,
+        ) -> Eat {
+            let [sender, _, channel, _account, _realname] = args;
+            plugin.as_ref().record(MembershipDelta::Join {
+                channel: strip_leading_colon(channel).to_owned(),
+                nick: sender_nick(sender).to_owned(),
+            });
+            Eat::None
+        }
+
+        fn part_cb<P: 'static + AsRef<MembershipStream>>(
+            plugin: &P,
+            _ph: PluginHandle<'_, P>,
+            args: <Part as Event<'_>>::Args,
+        ) -> Eat {
+            let [sender, _, channel, _reason] = args;
+            plugin.as_ref().record(MembershipDelta::Part {
+                channel: strip_leading_colon(channel).to_owned(),
+                nick: sender_nick(sender).to_owned(),
+            });
+            Eat::None
+        }
+
+        fn quit_cb<P: 'static + AsRef<MembershipStream>>(
+            plugin: &P,
+            _ph: PluginHandle<'_, P>,
+            args: <Quit as Event<'_>>::Args,
+        ) -> Eat {
+            let [sender, _, _reason] = args;
+            plugin.as_ref().record(MembershipDelta::Quit {
+                nick: sender_nick(sender).to_owned(),
+            });
+            Eat::None
+        }
+
+        fn nick_cb<P: 'static + AsRef<MembershipStream>>(
+            plugin: &P,
+            _ph: PluginHandle<'_, P>,
+            args: <Nick as Event<'_>>::Args,
+        ) -> Eat {
+            let [sender, _, new_nick] = args;
+            plugin.as_ref().record(MembershipDelta::Nick {
+                old_nick: sender_nick(sender).to_owned(),
+                new_nick: strip_leading_colon(new_nick).to_owned(),
+            });
+            Eat::None
+        }
+
+        fn kick_cb<P: 'static + AsRef<MembershipStream>>(
+            plugin: &P,
+            _ph: PluginHandle<'_, P>,
+            args: <Kick as Event<'_>>::Args,
+        ) -> Eat {
+            let [_sender, _, channel, target, _reason] = args;
+            plugin.as_ref().record(MembershipDelta::Part {
+                channel: strip_leading_colon(channel).to_owned(),
+                nick: target.to_owned(),
+            });
+            Eat::None
+        }
+
+        fn mode_cb<P: 'static + AsRef<MembershipStream>>(
+            plugin: &P,
+            _ph: PluginHandle<'_, P>,
+            args: <Mode as Event<'_>>::Args,
+        ) -> Eat {
+            let [_sender, _, target, modes, mode_args] = args;
+            plugin.as_ref().record(MembershipDelta::Mode {
+                channel: target.to_owned(),
+                modes: modes.to_owned(),
+                args: strip_leading_colon(mode_args).to_owned(),
+            });
+            Eat::None
+        }
+
+        self.hook_server(Join, Priority::Normal, join_cb);
+        self.hook_server(Part, Priority::Normal, part_cb);
+        self.hook_server(Quit, Priority::Normal, quit_cb);
+        self.hook_server(Nick, Priority::Normal, nick_cb);
+        self.hook_server(Kick, Priority::Normal, kick_cb);
+        self.hook_server(Mode, Priority::Normal, mode_cb);
+
+        self.hook_timer_with(resolution, move |plugin, ph| {
+            let deltas = plugin.as_ref().take_pending();
+            if !deltas.is_empty() {
+                on_deltas(plugin, ph, &deltas);
+            }
+            Timer::Continue
+        });
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn casefold_rfc1459() {
+        assert_eq!(casefold("Nick[a]\\B^"), "nick{a}|b~");
+    }
+
+    #[test]
+    fn sender_nick_forms() {
+        assert_eq!(sender_nick(":nick!user@host"), "nick");
+        assert_eq!(sender_nick("nick!user@host"), "nick");
+        assert_eq!(sender_nick(":nick"), "nick");
+    }
+
+    fn index_with_channel(channel: &str, nicks: &[(&str, Option<char>)]) -> UserIndex {
+        let index = UserIndex::new();
+        index.channels.borrow_mut().insert(
+            casefold(channel),
+            nicks
+                .iter()
+                .map(|&(nick, prefix)| {
+                    (
+                        casefold(nick),
+                        UserEntry {
+                            nick: nick.to_owned(),
+                            prefix,
+                            account: None,
+                        },
+                    )
+                })
+                .collect(),
+        );
+        index
+    }
+
+    fn entry<'a>(index: &'a UserIndex, channel: &str, nick: &str) -> Option<UserEntry> {
+        index
+            .channels
+            .borrow()
+            .get(&casefold(channel))
+            .and_then(|users| users.get(&casefold(nick)))
+            .cloned()
+    }
+
+    #[test]
+    fn join_part_quit() {
+        let index = index_with_channel("#chan", &[("alice", None)]);
+
+        index.on_join("#chan", "Bob", "*");
+        assert_eq!(entry(&index, "#chan", "bob").unwrap().nick(), "Bob");
+
+        index.on_leave("#chan", "BOB");
+        assert!(entry(&index, "#chan", "bob").is_none());
+
+        index.on_quit("Alice");
+        assert!(entry(&index, "#chan", "alice").is_none());
+    }
+
+    #[test]
+    fn untracked_channels_are_ignored() {
+        let index = UserIndex::new();
+        index.on_join("#chan", "alice", "*");
+        assert!(index.channels.borrow().is_empty());
+    }
+
+    #[test]
+    fn nick_change_applies_to_all_channels() {
+        let index = index_with_channel("#a", &[("alice", Some('@'))]);
+        index
+            .channels
+            .borrow_mut()
+            .insert(casefold("#b"), Default::default());
+        index.on_join("#b", "alice", "*");
+
+        index.on_nick("Alice", "alicia");
+        assert_eq!(entry(&index, "#a", "alicia").unwrap().prefix(), Some('@'));
+        assert!(entry(&index, "#b", "alicia").is_some());
+        assert!(entry(&index, "#a", "alice").is_none());
+    }
+
+    #[test]
+    fn mode_changes_update_prefixes() {
+        let index = index_with_channel("#chan", &[("alice", None), ("bob", Some('@'))]);
+
+        index.on_mode("#chan", "+o", "alice");
+        assert_eq!(entry(&index, "#chan", "alice").unwrap().prefix(), Some('@'));
+
+        index.on_mode("#chan", "-o+v", "bob bob");
+        assert_eq!(entry(&index, "#chan", "bob").unwrap().prefix(), Some('+'));
+
+        // voicing an op does not demote them
+        index.on_mode("#chan", "+v", "alice");
+        assert_eq!(entry(&index, "#chan", "alice").unwrap().prefix(), Some('@'));
+    }
+
+    #[test]
+    fn mode_arguments_are_consumed_by_non_prefix_modes() {
+        let index = index_with_channel("#chan", &[("alice", None)]);
+
+        // the ban mask takes the first argument, so +o applies to alice
+        index.on_mode("#chan", "+bo", "*!*@spam.example alice");
+        assert_eq!(entry(&index, "#chan", "alice").unwrap().prefix(), Some('@'));
+    }
+
+    #[test]
+    fn membership_stream_batches_deltas() {
+        let stream = MembershipStream::new();
+        assert!(stream.take_pending().is_empty());
+
+        stream.record(MembershipDelta::Join {
+            channel: "#chan".to_owned(),
+            nick: "alice".to_owned(),
+        });
+        stream.record(MembershipDelta::Quit {
+            nick: "bob".to_owned(),
+        });
+
+        let deltas = stream.take_pending();
+        assert_eq!(deltas.len(), 2);
+        assert!(matches!(
+            &deltas[0],
+            MembershipDelta::Join { channel, nick } if channel == "#chan" && nick == "alice"
+        ));
+        assert!(matches!(&deltas[1], MembershipDelta::Quit { nick } if nick == "bob"));
+
+        // delivery drains the batch
+        assert!(stream.take_pending().is_empty());
+    }
+}
@@ -1,5 +1,11 @@
 //! Sending modes.
 
+use std::convert::TryInto;
+use std::os::raw::c_char;
+use std::ptr;
+
+use crate::plugin::PluginHandle;
+
 /// Whether to add or remove a mode.
 ///
 /// Used with [`PluginHandle::send_modes`](crate::PluginHandle::send_modes).
@@ -11,3 +17,214 @@ pub enum Sign {
     /// Remove the mode.
     Remove,
 }
+
+/// Up to this many targets are submitted via an inline stack array,
+/// with no heap pointer buffer at all.
+const INLINE_TARGETS: usize = 8;
+
+/// A batch of targets for a mass mode change.
+///
+/// [`PluginHandle::send_modes`](crate::PluginHandle::send_modes) allocates two `Vec`s per call,
+/// which adds up when opping/voicing or banning hundreds of targets.
+/// A `ModeBatch` instead accumulates targets into a single reused buffer,
+/// which [`PluginHandle::send_mode_batch`](crate::PluginHandle::send_mode_batch)
+/// submits to HexChat in one pass
+/// (HexChat then splits the submission into the minimal number of `MODE` lines,
+/// respecting the server's advertised modes-per-line limit).
+/// Batches of up to 8 targets are submitted entirely from the stack;
+/// larger batches reuse an internal pointer buffer across flushes.
+///
+/// The buffers' capacities are retained across flushes,
+/// so a long-lived `ModeBatch` stops allocating once it has grown to its working size.
+#[derive(Debug, Default)]
+pub struct ModeBatch {
+    /// Target strings stored back-to-back, each null-terminated.
+    buf: String,
+    /// Byte offset of the start of each target in `buf`.
+    offsets: Vec<usize>,
+    /// Reused pointer buffer for batches of more than [`INLINE_TARGETS`] targets.
+    ptrs: Vec<*const c_char>,
+}
+
+impl ModeBatch {
+    /// Creates a new, empty `ModeBatch`.
+    pub fn new() -> Self {
+        Self::default()
+    }
+
+    /// Appends a target (e.g. a nickname or ban mask) to the batch.
+    ///
+    /// # Panics
+    ///
+    /// If `target` contains a null byte.
+    pub fn push(&mut self, target: &str) {
+        assert!(
+            !target.as_bytes().contains(&0),
+            "Interior null byte in send_modes target: {:?}",
+            target
+        );
+        self.offsets.push(self.buf.len());
+        self.buf.push_str(target);
+        self.buf.push('\0');
+    }
+
+    /// Appends every target from an iterator to the batch.
+    pub fn extend<I>(&mut self, targets: I)
+    where
+        I: IntoIterator,
+        I::Item: AsRef<str>,
+    {
+        for target in targets {
+            self.push(target.as_ref());
+        }
+    }
+
+    /// Returns the number of targets waiting to be sent.
+    pub fn len(&self) -> usize {
+        self.offsets.len()
+    }
+
+    /// Returns `true` if there are no targets waiting to be sent.
+    pub fn is_empty(&self) -> bool {
+        self.offsets.is_empty()
+    }
+
+    /// Discards all targets without sending them.
+    pub fn clear(&mut self) {
+        self.buf.clear();
+        self.offsets.clear();
+    }
+
+    /// Calls `f` with a null-terminated pointer per target, then empties the batch.
+    ///
+    /// Does not call `f` at all if the batch is empty.
+    fn flush_targets(&mut self, f: impl FnOnce(&mut [*const c_char])) {
+        match self.offsets.len() {
+            0 => return,
+            len if len <= INLINE_TARGETS => {
+                let mut ptrs = [ptr::null(); INLINE_TARGETS];
+                for (ptr, &offset) in ptrs.iter_mut().zip(&self.offsets) {
+                    *ptr = self.buf[offset..].as_ptr().cast();
+                }
+                f(&mut ptrs[..len]);
+            }
+            _ => {
+                self.ptrs.clear();
+                let buf = &self.buf;
+                self.ptrs.extend(
+                    self.offsets
+                        .iter()
+                        .map(|&offset| buf[offset..].as_ptr().cast::<c_char>()),
+                );
+                f(&mut self.ptrs);
+            }
+        }
+
+        self.buf.clear();
+        self.offsets.clear();
+    }
+}
+
+/// [Mode Batching](crate::mode::ModeBatch)
+impl<'ph, P> PluginHandle<'ph, P> {
+    /// Sends a channel mode change to every target in a batch, leaving it empty.
+    ///
+    /// Equivalent to [`PluginHandle::send_modes`](crate::PluginHandle::send_modes),
+    /// but without any per-call allocation for batches of up to 8 targets,
+    /// and with the internal pointer buffer reused across flushes for larger batches.
+    ///
+    /// # Examples
+    ///
+    /// ```rust
+    /// use hexavalent::PluginHandle;
+    /// use hexavalent::mode::{ModeBatch, Sign};
+    ///
+    /// fn ban_all<'a, P>(
+    ///     ph: PluginHandle<'_, P>,
+    ///     batch: &mut ModeBatch,
+    ///     masks: impl Iterator<Item = &'a str>,
+    /// ) {
+    ///     batch.extend(masks);
+    ///     // sends the minimal number of `MODE <targets> +b` lines
+    ///     ph.send_mode_batch(batch, Sign::Add, b'b');
+    /// }
+    /// ```
+    pub fn send_mode_batch(self, batch: &mut ModeBatch, sign: Sign, mode_char: u8) {
+        let sign = match sign {
+            Sign::Add => b'+',
+            Sign::Remove => b'-',
+        } as c_char;
+
+        let mode = mode_char as c_char;
+
+        batch.flush_targets(|targets| {
+            let ntargets = targets
+                .len()
+                .try_into()
+                .unwrap_or_else(|e| panic!("Too many send_modes targets: {}", e));
+
+            // Safety: handle is always valid; targets point to null-terminated strings in the batch
+            unsafe {
+                ((*self.handle).hexchat_send_modes)(
+                    self.handle,
+                    targets.as_mut_ptr(),
+                    ntargets,
+                    0,
+                    sign,
+                    mode,
+                )
+            }
+        });
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    fn flush(batch: &mut ModeBatch) -> Vec<String> {
+        let mut sent = Vec::new();
+        batch.flush_targets(|targets| {
+            for &mut target in targets {
+                // Safety: `target` points to a null-terminated string in the batch
+                let target = unsafe { std::ffi::CStr::from_ptr(target) };
+                sent.push(target.to_str().unwrap().to_owned());
+            }
+        });
+        sent
+    }
+
+    #[test]
+    fn flush_inline_targets() {
+        let mut batch = ModeBatch::new();
+        batch.extend(["alice", "bob"].iter());
+        assert_eq!(batch.len(), 2);
+
+        assert_eq!(flush(&mut batch), ["alice", "bob"]);
+        assert!(batch.is_empty());
+        assert!(batch.ptrs.is_empty());
+
+        // flushing an empty batch does not call back at all
+        batch.flush_targets(|_| panic!("Unexpected flush of empty batch"));
+    }
+
+    #[test]
+    fn flush_spilled_targets() {
+        let targets: Vec<String> = (0..INLINE_TARGETS + 1)
+            .map(|i| format!("user{}", i))
+            .collect();
+
+        let mut batch = ModeBatch::new();
+        batch.extend(&targets);
+
+        assert_eq!(flush(&mut batch), targets);
+        assert!(batch.is_empty());
+        assert_eq!(batch.ptrs.len(), INLINE_TARGETS + 1);
+    }
+
+    #[test]
+    #[should_panic]
+    fn push_invalid_null() {
+        ModeBatch::new().push("ali\0ce");
+    }
+}
@@ -0,0 +1,93 @@
+//! Nickname and channel name comparison.
+
+use std::cmp::Ordering;
+
+/// RFC1459 case folding table.
+///
+/// Maps `A-Z` to `a-z`, and `[`, `]`, `\`, `^` to `{`, `}`, `|`, `~` respectively,
+/// matching the table HexChat itself uses for `hexchat_nickcmp`.
+const RFC1459_CASEMAP: [u8; 256] = {
+    let mut table = [0; 256];
+    let mut i = 0;
+    while i < 256 {
+        table[i] = match i as u8 {
+            c @ b'A'..=b'Z' => c + (b'a' - b'A'),
+            b'[' => b'{',
+            b']' => b'}',
+            b'\\' => b'|',
+            b'^' => b'~',
+            c => c,
+        };
+        i += 1;
+    }
+    table
+};
+
+/// Folds one byte to its RFC1459 lowercase equivalent.
+pub(crate) fn casefold_byte(byte: u8) -> u8 {
+    RFC1459_CASEMAP[usize::from(byte)]
+}
+
+/// Performs a comparison of nicknames or channel names, compliant with RFC1459.
+///
+/// [RFC1459 says](https://tools.ietf.org/html/rfc1459#section-2.2):
+///
+/// > Because of IRC's scandanavian origin, the characters {}| are
+/// > considered to be the lower case equivalents of the characters \[\]\\,
+/// > respectively. This is a critical issue when determining the
+/// > equivalence of two nicknames.
+///
+/// Behaves the same as [`PluginHandle::nickcmp`](crate::PluginHandle::nickcmp),
+/// but runs entirely in Rust, with no allocation or FFI call.
+/// This makes it usable as the comparator for sorted-structure lookups in hot paths,
+/// e.g. comparing every joining nick against a large ban list.
+///
+/// # Examples
+///
+/// ```rust
+/// use std::cmp::Ordering;
+/// use hexavalent::nick::nickcmp;
+///
+/// assert_eq!(nickcmp("Alice", "alice"), Ordering::Equal);
+/// assert_eq!(nickcmp("[soft]", "{soft}"), Ordering::Equal);
+///
+/// fn is_banned(banned_nicks: &[String], nick: &str) -> bool {
+///     // `banned_nicks` must be sorted with the same comparator
+///     banned_nicks
+///         .binary_search_by(|banned| nickcmp(banned, nick))
+///         .is_ok()
+/// }
+/// ```
+pub fn nickcmp(s1: &str, s2: &str) -> Ordering {
+    let folded1 = s1.bytes().map(casefold_byte);
+    let folded2 = s2.bytes().map(casefold_byte);
+
+    folded1.cmp(folded2)
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn nickcmp_ascii_case_insensitive() {
+        assert_eq!(nickcmp("Nick", "nick"), Ordering::Equal);
+        assert_eq!(nickcmp("NICK", "nick"), Ordering::Equal);
+        assert_eq!(nickcmp("nick", "nick"), Ordering::Equal);
+    }
+
+    #[test]
+    fn nickcmp_scandinavian_brackets() {
+        assert_eq!(nickcmp("[a]", "{a}"), Ordering::Equal);
+        assert_eq!(nickcmp("a\\b", "a|b"), Ordering::Equal);
+        assert_eq!(nickcmp("a^b", "a~b"), Ordering::Equal);
+    }
+
+    #[test]
+    fn nickcmp_ordering() {
+        assert_eq!(nickcmp("abc", "abd"), Ordering::Less);
+        assert_eq!(nickcmp("abd", "abc"), Ordering::Greater);
+        assert_eq!(nickcmp("ab", "abc"), Ordering::Less);
+        assert_eq!(nickcmp("abc", "ab"), Ordering::Greater);
+    }
+}
@@ -10,24 +10,28 @@ use std::time::Duration;
 
 use time::OffsetDateTime;
 
-use crate::context::{Context, ContextHandle};
-use crate::event::print::PrintEvent;
+use crate::command::LazyWords;
+use crate::context::{Context, ContextGuard, ContextHandle};
+use crate::event::print::{find_print_event, PrintEvent};
 use crate::event::server::ServerEvent;
-use crate::event::{Event, EventAttrs};
+use crate::event::{Event, EventAttrs, LazyArgs};
 use crate::ffi::{
-    hexchat_event_attrs, hexchat_list, hexchat_plugin, int_to_result, word_to_iter, ListElem,
-    StrExt,
+    hexchat_context, hexchat_event_attrs, hexchat_list, hexchat_plugin, int_to_result,
+    word_to_iter, ListElem, StrExt,
 };
 use crate::gui::FakePluginHandle;
 use crate::hook::{Eat, HookHandle, Priority, Timer};
 use crate::info::private::FromInfoValue;
 use crate::info::Info;
 use crate::list::private::FromListElem;
-use crate::list::List;
+use crate::list::{List, ListSnapshot, ListStream};
 use crate::mode::Sign;
 use crate::pref::private::{FromPrefValue, PrefValue};
 use crate::pref::Pref;
-use crate::state::{catch_and_log_unwind, with_plugin_state};
+use crate::state::{
+    catch_and_log_unwind, free_closure, register_closure, with_closure, with_plugin_state,
+};
+use crate::stats;
 use crate::strip::{MircColors, TextAttrs};
 
 /// Must be implemented by all HexChat plugins.
@@ -184,7 +188,7 @@ pub trait Plugin: Default + 'static {
 #[derive(Debug)]
 pub struct PluginHandle<'ph, P> {
     /// Always points to a valid instance of `hexchat_plugin`.
-    handle: *mut hexchat_plugin,
+    pub(crate) handle: *mut hexchat_plugin,
     _lifetime: PhantomData<&'ph hexchat_plugin>,
     _plugin: PhantomData<P>,
 }
@@ -232,9 +236,9 @@ impl<'ph, P> PluginHandle<'ph, P> {
     pub fn print(self, text: &str) {
         let text = text.into_cstr();
         // Safety: `handle` is always valid
-        unsafe {
+        stats::record("print", || unsafe {
             ((*self.handle).hexchat_print)(self.handle, text.as_ptr());
-        }
+        })
     }
 
     /// Executes a command in the current [context](crate::PluginHandle#impl-3) as if it were typed into HexChat's input box after a `/`.
@@ -254,9 +258,9 @@ impl<'ph, P> PluginHandle<'ph, P> {
     pub fn command(self, cmd: &str) {
         let cmd = cmd.into_cstr();
         // Safety: `handle` is always valid
-        unsafe {
+        stats::record("command", || unsafe {
             ((*self.handle).hexchat_command)(self.handle, cmd.as_ptr());
-        }
+        })
     }
 
     /// Emits a print event in the current [context](crate::PluginHandle#impl-3).
@@ -298,16 +302,18 @@ impl<'ph, P> PluginHandle<'ph, P> {
             ];
 
             // Safety: `handle` is always valid
-            int_to_result(unsafe {
-                ((*self.handle).hexchat_emit_print)(
-                    self.handle,
-                    E::NAME,
-                    args[0],
-                    args[1],
-                    args[2],
-                    args[3],
-                    ptr::null::<c_char>(),
-                )
+            stats::record("emit_print", || {
+                int_to_result(unsafe {
+                    ((*self.handle).hexchat_emit_print)(
+                        self.handle,
+                        E::NAME,
+                        args[0],
+                        args[1],
+                        args[2],
+                        args[3],
+                        ptr::null::<c_char>(),
+                    )
+                })
             })
         })
     }
@@ -356,37 +362,140 @@ impl<'ph, P> PluginHandle<'ph, P> {
             ];
 
             // Safety: `handle` is always valid
-            int_to_result(unsafe {
-                let event_attrs = ((*self.handle).hexchat_event_attrs_create)(self.handle);
-                defer! { ((*self.handle).hexchat_event_attrs_free)(self.handle, event_attrs) };
-
-                ptr::write(
-                    &mut (*event_attrs).server_time_utc as *mut _,
-                    attrs.time().unix_timestamp(),
-                );
+            stats::record("emit_print_attrs", || {
+                int_to_result(unsafe {
+                    let event_attrs = ((*self.handle).hexchat_event_attrs_create)(self.handle);
+                    defer! { ((*self.handle).hexchat_event_attrs_free)(self.handle, event_attrs) };
 
-                #[cfg(feature = "__unstable_ircv3_line_in_event_attrs")]
-                let ircv3_line = attrs.ircv3_line().into_cstr();
-                #[cfg(feature = "__unstable_ircv3_line_in_event_attrs")]
-                ptr::write(
-                    &mut (*event_attrs).ircv3_line as *mut _,
-                    ircv3_line.as_ptr(),
-                );
+                    ptr::write(
+                        &mut (*event_attrs).server_time_utc as *mut _,
+                        attrs.time().unix_timestamp(),
+                    );
 
-                ((*self.handle).hexchat_emit_print_attrs)(
-                    self.handle,
-                    event_attrs,
-                    E::NAME,
-                    args[0],
-                    args[1],
-                    args[2],
-                    args[3],
-                    ptr::null::<c_char>(),
-                )
+                    #[cfg(feature = "__unstable_ircv3_line_in_event_attrs")]
+                    let ircv3_line = attrs.ircv3_line().into_cstr();
+                    #[cfg(feature = "__unstable_ircv3_line_in_event_attrs")]
+                    ptr::write(
+                        &mut (*event_attrs).ircv3_line as *mut _,
+                        ircv3_line.as_ptr(),
+                    );
+
+                    ((*self.handle).hexchat_emit_print_attrs)(
+                        self.handle,
+                        event_attrs,
+                        E::NAME,
+                        args[0],
+                        args[1],
+                        args[2],
+                        args[3],
+                        ptr::null::<c_char>(),
+                    )
+                })
             })
         })
     }
 
+    /// Emits a batch of print events in the current [context](crate::PluginHandle#impl-3), specifying their attributes.
+    ///
+    /// Equivalent to calling [`PluginHandle::emit_print_attrs`] for each event,
+    /// but the underlying attrs object is created once and rewritten per event,
+    /// instead of being created and freed around every emission.
+    /// Together with the reused argument conversion buffers,
+    /// this leaves one FFI call per event, which makes bulk emission
+    /// (e.g. backfilling a channel with thousands of timestamped messages from logs)
+    /// roughly linear in message bytes instead of FFI overhead.
+    ///
+    /// Stops at the first event that fails to emit, returning `Err`.
+    ///
+    /// Note that this triggers any print hooks registered for the events, so be careful to avoid infinite recursion
+    /// when calling this function from hook callbacks such as [`PluginHandle::hook_print_attrs`].
+    ///
+    /// Analogous to [`hexchat_emit_print_attrs`](https://hexchat.readthedocs.io/en/latest/plugins.html#c.hexchat_emit_print_attrs).
+    ///
+    /// # Examples
+    ///
+    /// ```rust
+    /// use hexavalent::PluginHandle;
+    /// use hexavalent::event::EventAttrs;
+    /// use hexavalent::event::print::ChannelMessage;
+    /// use time::OffsetDateTime;
+    ///
+    /// # #[cfg(not(feature = "__unstable_ircv3_line_in_event_attrs"))]
+    /// fn backfill_channel<P>(
+    ///     ph: PluginHandle<'_, P>,
+    ///     history: &[(i64, String, String)],
+    /// ) -> Result<(), ()> {
+    ///     ph.emit_print_attrs_batch(
+    ///         ChannelMessage,
+    ///         history.iter().map(|&(timestamp, ref user, ref text)| {
+    ///             let attrs = EventAttrs::new(OffsetDateTime::from_unix_timestamp(timestamp));
+    ///             (attrs, [user.as_str(), text.as_str(), "@\0", "$\0"])
+    ///         }),
+    ///     )
+    /// }
+    /// ```
+    pub fn emit_print_attrs_batch<'a, E: PrintEvent>(
+        self,
+        event: E,
+        events: impl IntoIterator<Item = (EventAttrs<'a>, <E as Event<'a>>::Args)>,
+    ) -> Result<(), ()> {
+        let _ = event;
+
+        // Safety: `handle` is always valid
+        let event_attrs = unsafe { ((*self.handle).hexchat_event_attrs_create)(self.handle) };
+        defer! {{
+            // Safety: `handle` is always valid; `event_attrs` was created above
+            unsafe { ((*self.handle).hexchat_event_attrs_free)(self.handle, event_attrs) };
+        }}
+
+        for (attrs, args) in events {
+            E::args_to_c(args, |args| {
+                assert!(
+                    args.len() <= 4,
+                    "bug in hexavalent - more than 4 args from PrintEvent"
+                );
+
+                let args: [*const c_char; 4] = [
+                    args.get(0).map_or_else(ptr::null, |a| a.as_ptr()),
+                    args.get(1).map_or_else(ptr::null, |a| a.as_ptr()),
+                    args.get(2).map_or_else(ptr::null, |a| a.as_ptr()),
+                    args.get(3).map_or_else(ptr::null, |a| a.as_ptr()),
+                ];
+
+                // Safety: `handle` is always valid; `event_attrs` was created above
+                stats::record("emit_print_attrs_batch", || {
+                    int_to_result(unsafe {
+                        ptr::write(
+                            &mut (*event_attrs).server_time_utc as *mut _,
+                            attrs.time().unix_timestamp(),
+                        );
+
+                        #[cfg(feature = "__unstable_ircv3_line_in_event_attrs")]
+                        let ircv3_line = attrs.ircv3_line().into_cstr();
+                        #[cfg(feature = "__unstable_ircv3_line_in_event_attrs")]
+                        ptr::write(
+                            &mut (*event_attrs).ircv3_line as *mut _,
+                            ircv3_line.as_ptr(),
+                        );
+
+                        ((*self.handle).hexchat_emit_print_attrs)(
+                            self.handle,
+                            event_attrs,
+                            E::NAME,
+                            args[0],
+                            args[1],
+                            args[2],
+                            args[3],
+                            ptr::null::<c_char>(),
+                        )
+                    })
+                })
+            })?;
+        }
+
+        Ok(())
+    }
+
     /// Sends channel mode changes to targets in the current [context](crate::PluginHandle#impl-3).
     ///
     /// Analogous to [`hexchat_send_modes`](https://hexchat.readthedocs.io/en/latest/plugins.html#c.hexchat_send_modes).
@@ -423,7 +532,7 @@ impl<'ph, P> PluginHandle<'ph, P> {
         let mode = mode_char as c_char;
 
         // Safety: handle is always valid
-        unsafe {
+        stats::record("send_modes", || unsafe {
             ((*self.handle).hexchat_send_modes)(
                 self.handle,
                 targets.as_mut_ptr(),
@@ -432,7 +541,7 @@ impl<'ph, P> PluginHandle<'ph, P> {
                 sign,
                 mode,
             )
-        }
+        })
     }
 
     /// Performs a comparison of nicknames or channel names, compliant with RFC1459.
@@ -445,7 +554,8 @@ impl<'ph, P> PluginHandle<'ph, P> {
     /// > equivalence of two nicknames.
     ///
     /// Note that, like other functions taking `&str`, this function will allocate if the provided strings are not already null-terminated.
-    /// This may be expensive; if you are calling this function in a loop, consider implementing your own RFC1459 string comparison.
+    /// This may be expensive; if you are calling this function in a loop, use [`nick::nickcmp`](crate::nick::nickcmp) instead,
+    /// which performs the same comparison without crossing the FFI boundary or allocating.
     /// (This function is provided mainly for API completeness.)
     ///
     /// Analogous to [`hexchat_nickcmp`](https://hexchat.readthedocs.io/en/latest/plugins.html#c.hexchat_nickcmp).
@@ -464,14 +574,20 @@ impl<'ph, P> PluginHandle<'ph, P> {
         let s2 = s2.into_cstr();
 
         // Safety: handle is always valid
-        let ordering =
-            unsafe { ((*self.handle).hexchat_nickcmp)(self.handle, s1.as_ptr(), s2.as_ptr()) };
+        let ordering = stats::record("nickcmp", || unsafe {
+            ((*self.handle).hexchat_nickcmp)(self.handle, s1.as_ptr(), s2.as_ptr())
+        });
 
         ordering.cmp(&0)
     }
 
     /// Strips mIRC colors and/or text attributes (bold, underline, etc.) from a string.
     ///
+    /// If you are stripping many strings (e.g. every incoming message),
+    /// consider [`strip::strip`](crate::strip::strip) instead,
+    /// which performs the same stripping without crossing the FFI boundary,
+    /// and avoids copying the string entirely when it contains no formatting.
+    ///
     /// Analogous to [`hexchat_strip`](https://hexchat.readthedocs.io/en/latest/plugins.html#c.hexchat_strip).
     ///
     /// # Examples
@@ -539,8 +655,9 @@ impl<'ph, P> PluginHandle<'ph, P> {
         let flags = mirc_flag | attrs_flag;
 
         // Safety: handle is always valid
-        let stripped_ptr =
-            unsafe { ((*self.handle).hexchat_strip)(self.handle, str.as_ptr(), -1, flags) };
+        let stripped_ptr = stats::record("strip", || unsafe {
+            ((*self.handle).hexchat_strip)(self.handle, str.as_ptr(), -1, flags)
+        });
 
         if stripped_ptr.is_null() {
             return f(Err(()));
@@ -596,7 +713,9 @@ impl<'ph, P> PluginHandle<'ph, P> {
         let _ = info;
 
         // Safety: handle is always valid
-        let ptr = unsafe { ((*self.handle).hexchat_get_info)(self.handle, I::NAME) };
+        let ptr = stats::record("get_info", || unsafe {
+            ((*self.handle).hexchat_get_info)(self.handle, I::NAME)
+        });
 
         if ptr.is_null() {
             return f(None);
@@ -647,9 +766,9 @@ impl<'ph, P> PluginHandle<'ph, P> {
         let mut int = 0;
 
         // Safety: handle is always valid
-        let result = unsafe {
+        let result = stats::record("get_pref", || unsafe {
             ((*self.handle).hexchat_get_prefs)(self.handle, Pr::NAME, &mut string, &mut int)
-        };
+        });
 
         // https://hexchat.readthedocs.io/en/latest/plugins.html#c.hexchat_get_prefs
         let value = match result {
@@ -706,11 +825,8 @@ impl<'ph, P> PluginHandle<'ph, P> {
     /// }
     /// ```
     pub fn get_list<L: List>(self, list: L) -> Result<Vec<<L as List>::Elem>, ()> {
-        self.get_list_with(
-            list,
-            #[inline(always)]
-            |list| list.map(|l| l.collect()),
-        )
+        // the stream knows the list's length, so the Vec is allocated exactly once
+        self.get_list_stream(list).map(Iterator::collect)
     }
 
     /// Gets a list of information, possibly specific to the current [context](crate::PluginHandle#impl-3).
@@ -760,7 +876,9 @@ impl<'ph, P> PluginHandle<'ph, P> {
         let _ = list;
 
         // Safety: handle is always valid
-        let list_ptr = unsafe { ((*self.handle).hexchat_list_get)(self.handle, L::NAME) };
+        let list_ptr = stats::record("get_list", || unsafe {
+            ((*self.handle).hexchat_list_get)(self.handle, L::NAME)
+        });
 
         if list_ptr.is_null() {
             return f(Err(()));
@@ -770,13 +888,13 @@ impl<'ph, P> PluginHandle<'ph, P> {
         // Safety: ListIter does not outlive this function, so there are no dangling pointers
         defer! { unsafe { ((*self.handle).hexchat_list_free)(self.handle, list_ptr) } }
 
-        struct ListIter<E: FromListElem> {
+        struct ListIter<E: for<'a> FromListElem<'a>> {
             handle: *mut hexchat_plugin,
             list: *mut hexchat_list,
             _elem: PhantomData<E>,
         }
 
-        impl<E: FromListElem> Iterator for ListIter<E> {
+        impl<E: for<'a> FromListElem<'a>> Iterator for ListIter<E> {
             type Item = E;
 
             fn next(&mut self) -> Option<Self::Item> {
@@ -799,6 +917,205 @@ impl<'ph, P> PluginHandle<'ph, P> {
             _elem: PhantomData,
         }))
     }
+
+    /// Gets a list of information, possibly specific to the current [context](crate::PluginHandle#impl-3),
+    /// passing each element to a closure without copying its fields.
+    ///
+    /// See the [`list`](crate::list) submodule for a list of lists.
+    ///
+    /// Behaves the same as [`PluginHandle::get_list`], but passes borrowed elements to `f`,
+    /// whose string fields are views into HexChat's own memory,
+    /// so the entire traversal performs no allocation.
+    ///
+    /// Avoid calling functions in `f` which could invalidate the list,
+    /// e.g. running commands that close channels or disconnect users.
+    ///
+    /// Analogous to [`hexchat_list_get`](https://hexchat.readthedocs.io/en/latest/plugins.html#c.hexchat_list_get) and related functions.
+    ///
+    /// # Examples
+    ///
+    /// ```rust
+    /// use hexavalent::PluginHandle;
+    /// use hexavalent::list::Users;
+    ///
+    /// fn count_ops<P>(ph: PluginHandle<'_, P>) -> Result<usize, ()> {
+    ///     let mut ops = 0;
+    ///     ph.get_list_borrowed_with(Users, |user| {
+    ///         if user.prefix() == Some('@') {
+    ///             ops += 1;
+    ///         }
+    ///     })?;
+    ///     Ok(ops)
+    /// }
+    /// ```
+    pub fn get_list_borrowed_with<L: List>(
+        self,
+        list: L,
+        mut f: impl FnMut(<L as List>::BorrowedElem<'_>),
+    ) -> Result<(), ()> {
+        let _ = list;
+
+        // Safety: handle is always valid
+        let list_ptr = stats::record("get_list", || unsafe {
+            ((*self.handle).hexchat_list_get)(self.handle, L::NAME)
+        });
+
+        if list_ptr.is_null() {
+            return Err(());
+        }
+
+        // Safety: handle is always valid; list_ptr was returned from hexchat_list_get
+        // Safety: borrowed elements do not outlive this function, so there are no dangling pointers
+        defer! { unsafe { ((*self.handle).hexchat_list_free)(self.handle, list_ptr) } }
+
+        // Safety: handle is always valid; list is valid
+        // Safety: hexchat_list_next can safely be called multiple times at the end of a list
+        while unsafe { ((*self.handle).hexchat_list_next)(self.handle, list_ptr) } != 0 {
+            // Safety: handle/list are valid until the list is freed, and hexchat_list_next returned true
+            let elem = unsafe { ListElem::new(&self.handle, &list_ptr) };
+
+            f(FromListElem::from_list_elem(elem));
+        }
+
+        Ok(())
+    }
+
+    /// Gets an owned snapshot of a list, possibly specific to the current [context](crate::PluginHandle#impl-3).
+    ///
+    /// See the [`list`](crate::list) submodule for a list of lists.
+    ///
+    /// Behaves the same as [`PluginHandle::get_list`],
+    /// but copies all string fields into one contiguous arena
+    /// and stores the fields struct-of-arrays,
+    /// so creating the snapshot performs a handful of allocations
+    /// regardless of the number of elements, and scanning it is cache-friendly.
+    /// Useful when snapshots are retained and scanned repeatedly,
+    /// e.g. when diffing channel state over time.
+    ///
+    /// Analogous to [`hexchat_list_get`](https://hexchat.readthedocs.io/en/latest/plugins.html#c.hexchat_list_get) and related functions.
+    ///
+    /// # Examples
+    ///
+    /// ```rust
+    /// use hexavalent::PluginHandle;
+    /// use hexavalent::list::Channels;
+    ///
+    /// fn print_laggy_channels<P>(ph: PluginHandle<'_, P>) {
+    ///     let channels = match ph.get_list_snapshot(Channels) {
+    ///         Ok(channels) => channels,
+    ///         Err(()) => return ph.print("Failed to get channels!\0"),
+    ///     };
+    ///     for channel in channels.iter() {
+    ///         if channel.lag_ms() > 1000 {
+    ///             ph.print(&format!("Channel {} is lagging.\0", channel.name()));
+    ///         }
+    ///     }
+    /// }
+    /// ```
+    pub fn get_list_snapshot<L: List>(self, list: L) -> Result<ListSnapshot<L>, ()> {
+        let _ = list;
+
+        // Safety: handle is always valid
+        let list_ptr = stats::record("get_list", || unsafe {
+            ((*self.handle).hexchat_list_get)(self.handle, L::NAME)
+        });
+
+        if list_ptr.is_null() {
+            return Err(());
+        }
+
+        // Safety: handle is always valid; list_ptr was returned from hexchat_list_get
+        // Safety: list elements do not outlive this function, so there are no dangling pointers
+        defer! { unsafe { ((*self.handle).hexchat_list_free)(self.handle, list_ptr) } }
+
+        let mut snapshot = ListSnapshot::new();
+
+        // Safety: handle is always valid; list is valid
+        // Safety: hexchat_list_next can safely be called multiple times at the end of a list
+        while unsafe { ((*self.handle).hexchat_list_next)(self.handle, list_ptr) } != 0 {
+            // Safety: handle/list are valid until the list is freed, and hexchat_list_next returned true
+            let elem = unsafe { ListElem::new(&self.handle, &list_ptr) };
+
+            snapshot.push(elem);
+        }
+
+        Ok(snapshot)
+    }
+
+    /// Gets a stream over a list's elements, possibly specific to the current [context](crate::PluginHandle#impl-3).
+    ///
+    /// See the [`list`](crate::list) submodule for a list of lists.
+    ///
+    /// Behaves the same as [`PluginHandle::get_list_with`],
+    /// but returns a [`ListStream`](crate::list::ListStream) which owns the underlying list
+    /// and frees it when dropped, instead of passing a `&mut dyn Iterator` to a closure,
+    /// so stepping through the elements is statically dispatched.
+    /// The stream also knows the list's exact length (counted by a first cheap pass),
+    /// so collecting it allocates once instead of regrowing.
+    ///
+    /// Avoid calling functions which could invalidate the list while the stream is live,
+    /// e.g. running commands that close channels or disconnect users.
+    ///
+    /// Analogous to [`hexchat_list_get`](https://hexchat.readthedocs.io/en/latest/plugins.html#c.hexchat_list_get) and related functions.
+    ///
+    /// # Examples
+    ///
+    /// ```rust
+    /// use hexavalent::PluginHandle;
+    /// use hexavalent::list::Channels;
+    ///
+    /// fn count_lagging_channels<P>(ph: PluginHandle<'_, P>) -> Result<usize, ()> {
+    ///     let mut channels = ph.get_list_stream(Channels)?;
+    ///     let mut lagging = 0;
+    ///     while let Some(channel) = channels.next_borrowed() {
+    ///         if channel.lag_ms() > 1000 {
+    ///             lagging += 1;
+    ///         }
+    ///     }
+    ///     Ok(lagging)
+    /// }
+    /// ```
+    pub fn get_list_stream<L: List>(self, list: L) -> Result<ListStream<'ph, L>, ()> {
+        let _ = list;
+
+        // a first cheap pass counts the elements, so that the stream can report an exact size;
+        // no user code runs between the passes, so the count cannot go stale
+        let len = {
+            // Safety: handle is always valid
+            let list_ptr = stats::record("get_list", || unsafe {
+                ((*self.handle).hexchat_list_get)(self.handle, L::NAME)
+            });
+
+            if list_ptr.is_null() {
+                return Err(());
+            }
+
+            // Safety: handle is always valid; list_ptr was returned from hexchat_list_get
+            defer! { unsafe { ((*self.handle).hexchat_list_free)(self.handle, list_ptr) } }
+
+            let mut len = 0_usize;
+
+            // Safety: handle is always valid; list is valid
+            while unsafe { ((*self.handle).hexchat_list_next)(self.handle, list_ptr) } != 0 {
+                len += 1;
+            }
+
+            len
+        };
+
+        // Safety: handle is always valid
+        let list_ptr = stats::record("get_list", || unsafe {
+            ((*self.handle).hexchat_list_get)(self.handle, L::NAME)
+        });
+
+        if list_ptr.is_null() {
+            return Err(());
+        }
+
+        // Safety: handle is valid for 'ph; list_ptr was returned from hexchat_list_get,
+        // holds `len` elements, and is owned (and freed) by the stream
+        Ok(unsafe { ListStream::new(self.handle, list_ptr, len) })
+    }
 }
 
 /// [Hook Functions](https://hexchat.readthedocs.io/en/latest/plugins.html#hook-functions)
@@ -995,83 +1312,87 @@ impl<'ph, P: 'static> PluginHandle<'ph, P> {
         unsafe { HookHandle::new(hook) }
     }
 
-    /// Registers a print event hook with HexChat.
+    /// Registers a command hook with HexChat, decoding the command's words lazily.
     ///
-    /// See the [`event::print`](crate::event::print) submodule for a list of print events.
+    /// Behaves the same as [`PluginHandle::hook_command`],
+    /// but passes the words as a [`LazyWords`](crate::command::LazyWords) view
+    /// which decodes and UTF-8-validates a word only when it is accessed,
+    /// instead of eagerly converting the entire command line up front.
     ///
     /// Note that `callback` is a function pointer and not an `impl Fn()`.
     /// This means that it cannot capture any variables; instead, use `plugin` to store state.
     /// See the [impl header](crate::PluginHandle#impl-2) for more details.
     ///
-    /// _Also_ note that passing a closure as `callback` will ICE the compiler,
-    /// due to `rustc` [bug #62529](https://github.com/rust-lang/rust/issues/62529).
-    /// A `fn` item must be used instead, as in the example below.
-    ///
     /// Returns a [`HookHandle`](crate::hook::HookHandle) which can be passed to
     /// [`PluginHandle::unhook`] to unregister the hook.
     ///
-    /// Analogous to [`hexchat_hook_print`](https://hexchat.readthedocs.io/en/latest/plugins.html#c.hexchat_hook_print).
+    /// Analogous to [`hexchat_hook_command`](https://hexchat.readthedocs.io/en/latest/plugins.html#c.hexchat_hook_command).
     ///
     /// # Examples
     ///
     /// ```rust
     /// use hexavalent::PluginHandle;
-    /// use hexavalent::event::Event;
-    /// use hexavalent::event::print::YouPartWithReason;
+    /// use hexavalent::command::LazyWords;
     /// use hexavalent::hook::{Eat, Priority};
     ///
     /// struct MyPlugin;
     ///
-    /// fn hook_you_part(ph: PluginHandle<'_, MyPlugin>) {
-    ///     ph.hook_print(YouPartWithReason, Priority::Normal, you_part_cb);
+    /// fn hook_op(ph: PluginHandle<'_, MyPlugin>) {
+    ///     ph.hook_command_lazy(
+    ///         "OptionalOp",
+    ///         "Usage: OPTIONALOP [<nick>], ops the named user, or everyone's favorite user",
+    ///         Priority::Normal,
+    ///         optionalop_cb,
+    ///     );
     /// }
     ///
-    /// fn you_part_cb(
+    /// fn optionalop_cb(
     ///     plugin: &MyPlugin,
     ///     ph: PluginHandle<'_, MyPlugin>,
-    ///     args: <YouPartWithReason as Event<'_>>::Args
+    ///     words: LazyWords<'_>,
     /// ) -> Eat {
-    ///     let [your_nick, your_host, channel, reason] = args;
-    ///     ph.print(&format!("You left channel {}: {}.", channel, reason));
-    ///     Eat::HexChat
+    ///     // only the accessed word is decoded
+    ///     let nick = words.get(1).unwrap_or("xX_coolgal_Xx");
+    ///     ph.command(&format!("OP {}", nick));
+    ///     Eat::All
     /// }
     /// ```
-    pub fn hook_print<E: PrintEvent>(
+    pub fn hook_command_lazy(
         self,
-        event: E,
+        name: &str,
+        help_text: &str,
         priority: Priority,
-        callback: fn(plugin: &P, ph: PluginHandle<'_, P>, args: <E as Event<'_>>::Args) -> Eat,
+        callback: fn(plugin: &P, ph: PluginHandle<'_, P>, words: LazyWords<'_>) -> Eat,
     ) -> HookHandle {
-        extern "C" fn hook_print_callback<P: 'static, E: PrintEvent>(
+        extern "C" fn hook_command_lazy_callback<P: 'static>(
             word: *mut *mut c_char,
+            _word_eol: *mut *mut c_char,
             user_data: *mut c_void,
         ) -> c_int {
-            catch_and_log_unwind("hook_print_callback", || {
+            catch_and_log_unwind("hook_command_lazy_callback", || {
                 // Safety: this is exactly the type we pass into user_data below
-                let callback: fn(
-                    plugin: &P,
-                    ph: PluginHandle<'_, P>,
-                    args: <E as Event<'_>>::Args,
-                ) -> Eat = unsafe { mem::transmute(user_data) };
+                let callback: fn(plugin: &P, ph: PluginHandle<'_, P>, words: LazyWords<'_>) -> Eat =
+                    unsafe { mem::transmute(user_data) };
 
                 // Safety: `word` is a valid word pointer for this entire callback
-                let word = unsafe { word_to_iter(&word) };
-                let args = E::args_from_words(word, iter::empty());
+                let words = unsafe { LazyWords::new(word) };
 
-                with_plugin_state(|plugin, ph| callback(plugin, ph, args))
+                with_plugin_state(|plugin, ph| callback(plugin, ph, words))
             })
             .unwrap_or(Eat::None) as c_int
         }
 
-        let _ = event;
+        let name = name.into_cstr();
+        let help_text = help_text.into_cstr();
 
         // Safety: handle is always valid
         let hook = unsafe {
-            ((*self.handle).hexchat_hook_print)(
+            ((*self.handle).hexchat_hook_command)(
                 self.handle,
-                E::NAME,
+                name.as_ptr(),
                 priority as c_int,
-                hook_print_callback::<P, E>,
+                hook_command_lazy_callback::<P>,
+                help_text.as_ptr(),
                 callback as *mut c_void,
             )
         };
@@ -1083,93 +1404,744 @@ impl<'ph, P: 'static> PluginHandle<'ph, P> {
         unsafe { HookHandle::new(hook) }
     }
 
-    /// Registers a print event hook with HexChat, capturing the event's attributes.
-    ///
-    /// See the [`event::print`](crate::event::print) submodule for a list of print events.
+    /// Registers a command hook with HexChat, with a callback that can capture variables.
     ///
-    /// Note that `callback` is a function pointer and not an `impl Fn()`.
-    /// This means that it cannot capture any variables; instead, use `plugin` to store state.
-    /// See the [impl header](crate::PluginHandle#impl-2) for more details.
+    /// Behaves the same as [`PluginHandle::hook_command`],
+    /// but `callback` is an `impl Fn` instead of a function pointer, so it can capture variables.
+    /// The closure is boxed once, when the hook is registered,
+    /// and dispatched by slot index afterwards, so running the command does not allocate.
     ///
-    /// _Also_ note that passing a closure as `callback` will ICE the compiler,
-    /// due to `rustc` [bug #62529](https://github.com/rust-lang/rust/issues/62529).
-    /// A `fn` item must be used instead, as in the example below.
+    /// The closure is dropped when the hook is passed to [`PluginHandle::unhook`],
+    /// or when your plugin is unloaded.
+    /// It is safe for the closure to unhook itself.
     ///
     /// Returns a [`HookHandle`](crate::hook::HookHandle) which can be passed to
     /// [`PluginHandle::unhook`] to unregister the hook.
     ///
-    /// Analogous to [`hexchat_hook_print_attrs`](https://hexchat.readthedocs.io/en/latest/plugins.html#c.hexchat_hook_print_attrs).
+    /// Analogous to [`hexchat_hook_command`](https://hexchat.readthedocs.io/en/latest/plugins.html#c.hexchat_hook_command).
     ///
     /// # Examples
     ///
     /// ```rust
     /// use hexavalent::PluginHandle;
-    /// use hexavalent::event::{Event, EventAttrs};
-    /// use hexavalent::event::print::YouPartWithReason;
     /// use hexavalent::hook::{Eat, Priority};
     ///
     /// struct MyPlugin;
     ///
-    /// fn hook_you_part(ph: PluginHandle<'_, MyPlugin>) {
-    ///     ph.hook_print_attrs(YouPartWithReason, Priority::Normal, you_part_cb);
-    /// }
-    ///
-    /// fn you_part_cb(
-    ///     plugin: &MyPlugin,
-    ///     ph: PluginHandle<'_, MyPlugin>,
-    ///     attrs: EventAttrs,
-    ///     args: <YouPartWithReason as Event<'_>>::Args
-    /// ) -> Eat {
-    ///     let [your_nick, your_host, channel, reason] = args;
-    ///     ph.print(&format!("You left channel {} at {}: {}.", channel, attrs.time(), reason));
-    ///     Eat::HexChat
+    /// fn add_greeting_command(ph: PluginHandle<'_, MyPlugin>, greeting: String) {
+    ///     ph.hook_command_with(
+    ///         "greet\0",
+    ///         "Usage: GREET <name>, prints a greeting locally\0",
+    ///         Priority::Normal,
+    ///         move |plugin, ph, words| {
+    ///             ph.print(&format!("{} {}!\0", greeting, words[1]));
+    ///             Eat::All
+    ///         }
+    ///     );
     /// }
     /// ```
-    pub fn hook_print_attrs<E: PrintEvent>(
+    pub fn hook_command_with<F>(
         self,
-        event: E,
+        name: &str,
+        help_text: &str,
         priority: Priority,
-        callback: fn(
-            plugin: &P,
-            ph: PluginHandle<'_, P>,
-            attrs: EventAttrs<'_>,
-            args: <E as Event<'_>>::Args,
-        ) -> Eat,
-    ) -> HookHandle {
+        callback: F,
+    ) -> HookHandle
+    where
+        F: Fn(&P, PluginHandle<'_, P>, &[&str]) -> Eat + 'static,
+    {
+        extern "C" fn hook_command_with_callback<P: 'static, F>(
+            word: *mut *mut c_char,
+            _word_eol: *mut *mut c_char,
+            user_data: *mut c_void,
+        ) -> c_int
+        where
+            F: Fn(&P, PluginHandle<'_, P>, &[&str]) -> Eat + 'static,
+        {
+            catch_and_log_unwind("hook_command_with_callback", || {
+                // this is exactly the slot index we pass into user_data below
+                let slot = user_data as usize;
+
+                // Safety: `word` is a valid word pointer for this entire callback
+                let word = unsafe { word_to_iter(&word) };
+
+                let mut words = [""; 32];
+
+                for (i, (ws, w)) in words.iter_mut().zip(word).enumerate() {
+                    *ws = w
+                        .to_str()
+                        .unwrap_or_else(|e| panic!("Invalid UTF8 in field index {}: {}", i, e));
+                }
+
+                with_plugin_state(|plugin, ph| {
+                    with_closure::<F, _>(slot, |callback| callback(plugin, ph, &words))
+                })
+            })
+            .unwrap_or(Eat::None) as c_int
+        }
+
+        let name = name.into_cstr();
+        let help_text = help_text.into_cstr();
+
+        let slot = register_closure(Box::new(callback));
+
+        // Safety: handle is always valid
+        let hook = unsafe {
+            ((*self.handle).hexchat_hook_command)(
+                self.handle,
+                name.as_ptr(),
+                priority as c_int,
+                hook_command_with_callback::<P, F>,
+                help_text.as_ptr(),
+                slot as *mut c_void,
+            )
+        };
+
+        let hook = NonNull::new(hook)
+            .unwrap_or_else(|| panic!("Hook handle was null, should be infallible"));
+
+        // Safety: hook was returned by HexChat; hook is not used after this
+        unsafe { HookHandle::new(hook) }.with_closure_slot(slot)
+    }
+
+    /// Registers a print event hook with HexChat.
+    ///
+    /// See the [`event::print`](crate::event::print) submodule for a list of print events.
+    ///
+    /// Note that `callback` is a function pointer and not an `impl Fn()`.
+    /// This means that it cannot capture any variables; instead, use `plugin` to store state.
+    /// See the [impl header](crate::PluginHandle#impl-2) for more details.
+    ///
+    /// _Also_ note that passing a closure as `callback` will ICE the compiler,
+    /// due to `rustc` [bug #62529](https://github.com/rust-lang/rust/issues/62529).
+    /// A `fn` item must be used instead, as in the example below.
+    ///
+    /// Returns a [`HookHandle`](crate::hook::HookHandle) which can be passed to
+    /// [`PluginHandle::unhook`] to unregister the hook.
+    ///
+    /// Analogous to [`hexchat_hook_print`](https://hexchat.readthedocs.io/en/latest/plugins.html#c.hexchat_hook_print).
+    ///
+    /// # Examples
+    ///
+    /// ```rust
+    /// use hexavalent::PluginHandle;
+    /// use hexavalent::event::Event;
+    /// use hexavalent::event::print::YouPartWithReason;
+    /// use hexavalent::hook::{Eat, Priority};
+    ///
+    /// struct MyPlugin;
+    ///
+    /// fn hook_you_part(ph: PluginHandle<'_, MyPlugin>) {
+    ///     ph.hook_print(YouPartWithReason, Priority::Normal, you_part_cb);
+    /// }
+    ///
+    /// fn you_part_cb(
+    ///     plugin: &MyPlugin,
+    ///     ph: PluginHandle<'_, MyPlugin>,
+    ///     args: <YouPartWithReason as Event<'_>>::Args
+    /// ) -> Eat {
+    ///     let [your_nick, your_host, channel, reason] = args;
+    ///     ph.print(&format!("You left channel {}: {}.", channel, reason));
+    ///     Eat::HexChat
+    /// }
+    /// ```
+    pub fn hook_print<E: PrintEvent>(
+        self,
+        event: E,
+        priority: Priority,
+        callback: fn(plugin: &P, ph: PluginHandle<'_, P>, args: <E as Event<'_>>::Args) -> Eat,
+    ) -> HookHandle {
+        extern "C" fn hook_print_callback<P: 'static, E: PrintEvent>(
+            word: *mut *mut c_char,
+            user_data: *mut c_void,
+        ) -> c_int {
+            catch_and_log_unwind("hook_print_callback", || {
+                // Safety: this is exactly the type we pass into user_data below
+                let callback: fn(
+                    plugin: &P,
+                    ph: PluginHandle<'_, P>,
+                    args: <E as Event<'_>>::Args,
+                ) -> Eat = unsafe { mem::transmute(user_data) };
+
+                // Safety: `word` is a valid word pointer for this entire callback
+                let word = unsafe { word_to_iter(&word) };
+                let args = E::args_from_words(word, iter::empty());
+
+                with_plugin_state(|plugin, ph| callback(plugin, ph, args))
+            })
+            .unwrap_or(Eat::None) as c_int
+        }
+
+        let _ = event;
+
+        // Safety: handle is always valid
+        let hook = unsafe {
+            ((*self.handle).hexchat_hook_print)(
+                self.handle,
+                E::NAME,
+                priority as c_int,
+                hook_print_callback::<P, E>,
+                callback as *mut c_void,
+            )
+        };
+
+        let hook = NonNull::new(hook)
+            .unwrap_or_else(|| panic!("Hook handle was null, should be infallible"));
+
+        // Safety: hook was returned by HexChat; hook is not used after this
+        unsafe { HookHandle::new(hook) }
+    }
+
+    /// Registers a print event hook with HexChat, decoding the event's arguments lazily.
+    ///
+    /// Behaves the same as [`PluginHandle::hook_print`],
+    /// but passes the arguments as a [`LazyArgs`](crate::event::LazyArgs) view
+    /// which decodes and UTF-8-validates a field only when it is accessed,
+    /// instead of eagerly converting every field up front.
+    /// Useful for hooks on high-volume events which inspect only some fields.
+    ///
+    /// Note that `callback` is a function pointer and not an `impl Fn()`.
+    /// This means that it cannot capture any variables; instead, use `plugin` to store state.
+    /// See the [impl header](crate::PluginHandle#impl-2) for more details.
+    ///
+    /// Returns a [`HookHandle`](crate::hook::HookHandle) which can be passed to
+    /// [`PluginHandle::unhook`] to unregister the hook.
+    ///
+    /// Analogous to [`hexchat_hook_print`](https://hexchat.readthedocs.io/en/latest/plugins.html#c.hexchat_hook_print).
+    ///
+    /// # Examples
+    ///
+    /// ```rust
+    /// use hexavalent::PluginHandle;
+    /// use hexavalent::event::LazyArgs;
+    /// use hexavalent::event::print::ChannelMessage;
+    /// use hexavalent::hook::{Eat, Priority};
+    ///
+    /// struct MyPlugin;
+    ///
+    /// fn hook_message(ph: PluginHandle<'_, MyPlugin>) {
+    ///     ph.hook_print_lazy(ChannelMessage, Priority::Normal, message_cb);
+    /// }
+    ///
+    /// fn message_cb(
+    ///     plugin: &MyPlugin,
+    ///     ph: PluginHandle<'_, MyPlugin>,
+    ///     args: LazyArgs<'_, ChannelMessage>,
+    /// ) -> Eat {
+    ///     // only the text field (index 1) is decoded, the other fields are skipped
+    ///     if args.arg(1).contains("boo") {
+    ///         ph.print("Boo!");
+    ///     }
+    ///     Eat::None
+    /// }
+    /// ```
+    pub fn hook_print_lazy<E: PrintEvent>(
+        self,
+        event: E,
+        priority: Priority,
+        callback: fn(plugin: &P, ph: PluginHandle<'_, P>, args: LazyArgs<'_, E>) -> Eat,
+    ) -> HookHandle {
+        extern "C" fn hook_print_lazy_callback<P: 'static, E: PrintEvent>(
+            word: *mut *mut c_char,
+            user_data: *mut c_void,
+        ) -> c_int {
+            catch_and_log_unwind("hook_print_lazy_callback", || {
+                // Safety: this is exactly the type we pass into user_data below
+                let callback: fn(
+                    plugin: &P,
+                    ph: PluginHandle<'_, P>,
+                    args: LazyArgs<'_, E>,
+                ) -> Eat = unsafe { mem::transmute(user_data) };
+
+                // Safety: `word` is a valid word pointer for this entire callback;
+                // print events have no eol field, so `word_eol` may be null
+                let args = unsafe { LazyArgs::new(word, ptr::null_mut()) };
+
+                with_plugin_state(|plugin, ph| callback(plugin, ph, args))
+            })
+            .unwrap_or(Eat::None) as c_int
+        }
+
+        let _ = event;
+
+        // Safety: handle is always valid
+        let hook = unsafe {
+            ((*self.handle).hexchat_hook_print)(
+                self.handle,
+                E::NAME,
+                priority as c_int,
+                hook_print_lazy_callback::<P, E>,
+                callback as *mut c_void,
+            )
+        };
+
+        let hook = NonNull::new(hook)
+            .unwrap_or_else(|| panic!("Hook handle was null, should be infallible"));
+
+        // Safety: hook was returned by HexChat; hook is not used after this
+        unsafe { HookHandle::new(hook) }
+    }
+
+    /// Registers a print event hook with HexChat, with a callback that can capture variables.
+    ///
+    /// Behaves the same as [`PluginHandle::hook_print`],
+    /// but `callback` is an `impl Fn` instead of a function pointer, so it can capture variables.
+    /// The closure is boxed once, when the hook is registered,
+    /// and dispatched by slot index afterwards, so handling an event does not allocate.
+    ///
+    /// The closure is dropped when the hook is passed to [`PluginHandle::unhook`],
+    /// or when your plugin is unloaded.
+    /// It is safe for the closure to unhook itself.
+    ///
+    /// Returns a [`HookHandle`](crate::hook::HookHandle) which can be passed to
+    /// [`PluginHandle::unhook`] to unregister the hook.
+    ///
+    /// Analogous to [`hexchat_hook_print`](https://hexchat.readthedocs.io/en/latest/plugins.html#c.hexchat_hook_print).
+    ///
+    /// # Examples
+    ///
+    /// ```rust
+    /// use hexavalent::PluginHandle;
+    /// use hexavalent::event::print::ChannelMessage;
+    /// use hexavalent::hook::{Eat, Priority};
+    ///
+    /// struct MyPlugin;
+    ///
+    /// fn hook_message(ph: PluginHandle<'_, MyPlugin>, watched_word: String) {
+    ///     ph.hook_print_with(ChannelMessage, Priority::Normal, move |plugin, ph, args| {
+    ///         let [nick, text, _, _] = args;
+    ///         if text.contains(&watched_word) {
+    ///             ph.print(&format!("{} mentioned {}!\0", nick, watched_word));
+    ///         }
+    ///         Eat::None
+    ///     });
+    /// }
+    /// ```
+    pub fn hook_print_with<E, F>(self, event: E, priority: Priority, callback: F) -> HookHandle
+    where
+        E: PrintEvent,
+        F: for<'a> Fn(&P, PluginHandle<'_, P>, <E as Event<'a>>::Args) -> Eat + 'static,
+    {
+        extern "C" fn hook_print_with_callback<P: 'static, E, F>(
+            word: *mut *mut c_char,
+            user_data: *mut c_void,
+        ) -> c_int
+        where
+            E: PrintEvent,
+            F: for<'a> Fn(&P, PluginHandle<'_, P>, <E as Event<'a>>::Args) -> Eat + 'static,
+        {
+            catch_and_log_unwind("hook_print_with_callback", || {
+                // this is exactly the slot index we pass into user_data below
+                let slot = user_data as usize;
+
+                // Safety: `word` is a valid word pointer for this entire callback
+                let word = unsafe { word_to_iter(&word) };
+                let args = E::args_from_words(word, iter::empty());
+
+                with_plugin_state(|plugin, ph| {
+                    with_closure::<F, _>(slot, |callback| callback(plugin, ph, args))
+                })
+            })
+            .unwrap_or(Eat::None) as c_int
+        }
+
+        let _ = event;
+
+        let slot = register_closure(Box::new(callback));
+
+        // Safety: handle is always valid
+        let hook = unsafe {
+            ((*self.handle).hexchat_hook_print)(
+                self.handle,
+                E::NAME,
+                priority as c_int,
+                hook_print_with_callback::<P, E, F>,
+                slot as *mut c_void,
+            )
+        };
+
+        let hook = NonNull::new(hook)
+            .unwrap_or_else(|| panic!("Hook handle was null, should be infallible"));
+
+        // Safety: hook was returned by HexChat; hook is not used after this
+        unsafe { HookHandle::new(hook) }.with_closure_slot(slot)
+    }
+
+    /// Registers a print event hook with HexChat, with the event chosen by name at runtime.
+    ///
+    /// Behaves the same as [`PluginHandle::hook_print`],
+    /// but the event is looked up by name in a static table of all print events
+    /// instead of being fixed at compile time,
+    /// so a single call site can hook events named in e.g. user configuration.
+    /// The lookup is a binary search over the table and performs no allocation.
+    ///
+    /// Since the event's arity is not known at compile time,
+    /// `callback` receives the event's arguments as a slice with one element per field.
+    ///
+    /// Returns `Err(())` if `name` is not a print event.
+    /// The special print events in [`event::print::special`](crate::event::print::special)
+    /// cannot be hooked by name; use [`PluginHandle::hook_print`] instead.
+    ///
+    /// Note that `callback` is a function pointer and not an `impl Fn()`.
+    /// This means that it cannot capture any variables; instead, use `plugin` to store state.
+    /// See the [impl header](crate::PluginHandle#impl-2) for more details.
+    ///
+    /// On success, returns a [`HookHandle`](crate::hook::HookHandle) which can be passed to
+    /// [`PluginHandle::unhook`] to unregister the hook.
+    ///
+    /// Analogous to [`hexchat_hook_print`](https://hexchat.readthedocs.io/en/latest/plugins.html#c.hexchat_hook_print).
+    ///
+    /// # Examples
+    ///
+    /// ```rust
+    /// use hexavalent::PluginHandle;
+    /// use hexavalent::hook::{Eat, Priority};
+    ///
+    /// struct MyPlugin;
+    ///
+    /// fn hook_configured_events(ph: PluginHandle<'_, MyPlugin>, event_names: &[&str]) {
+    ///     for name in event_names {
+    ///         let hook = ph.hook_print_dyn(name, Priority::Normal, |plugin, ph, args| {
+    ///             ph.print(&format!("Saw an event with {} fields\0", args.len()));
+    ///             Eat::None
+    ///         });
+    ///         if hook.is_err() {
+    ///             ph.print(&format!("Unknown print event: {}\0", name));
+    ///         }
+    ///     }
+    /// }
+    /// ```
+    pub fn hook_print_dyn(
+        self,
+        name: &str,
+        priority: Priority,
+        callback: fn(plugin: &P, ph: PluginHandle<'_, P>, args: &[&str]) -> Eat,
+    ) -> Result<HookHandle, ()> {
+        extern "C" fn hook_print_dyn_callback<P: 'static, const FIELD_COUNT: usize>(
+            word: *mut *mut c_char,
+            user_data: *mut c_void,
+        ) -> c_int {
+            catch_and_log_unwind("hook_print_dyn_callback", || {
+                // Safety: this is exactly the type we pass into user_data below
+                let callback: fn(plugin: &P, ph: PluginHandle<'_, P>, args: &[&str]) -> Eat =
+                    unsafe { mem::transmute(user_data) };
+
+                // Safety: `word` is a valid word pointer for this entire callback
+                let word = unsafe { word_to_iter(&word) };
+
+                let mut words = [""; FIELD_COUNT];
+
+                for (i, (ws, w)) in words.iter_mut().zip(word).enumerate() {
+                    *ws = w
+                        .to_str()
+                        .unwrap_or_else(|e| panic!("Invalid UTF8 in field index {}: {}", i, e));
+                }
+
+                with_plugin_state(|plugin, ph| callback(plugin, ph, &words))
+            })
+            .unwrap_or(Eat::None) as c_int
+        }
+
+        let entry = find_print_event(name).ok_or(())?;
+
+        // the trampoline is monomorphized per field count, so that the callback
+        // sees a slice with exactly the event's arity
+        let trampoline: extern "C" fn(*mut *mut c_char, *mut c_void) -> c_int =
+            match entry.field_count {
+                0 => hook_print_dyn_callback::<P, 0>,
+                1 => hook_print_dyn_callback::<P, 1>,
+                2 => hook_print_dyn_callback::<P, 2>,
+                3 => hook_print_dyn_callback::<P, 3>,
+                4 => hook_print_dyn_callback::<P, 4>,
+                n => panic!("Unsupported field count {} for event '{}'", n, entry.name),
+            };
+
+        // Safety: handle is always valid; `name_c` is null-terminated and static
+        let hook = unsafe {
+            ((*self.handle).hexchat_hook_print)(
+                self.handle,
+                entry.name_c.as_ptr().cast(),
+                priority as c_int,
+                trampoline,
+                callback as *mut c_void,
+            )
+        };
+
+        let hook = NonNull::new(hook)
+            .unwrap_or_else(|| panic!("Hook handle was null, should be infallible"));
+
+        // Safety: hook was returned by HexChat; hook is not used after this
+        Ok(unsafe { HookHandle::new(hook) })
+    }
+
+    /// Registers a print event hook with HexChat, capturing the event's attributes.
+    ///
+    /// See the [`event::print`](crate::event::print) submodule for a list of print events.
+    ///
+    /// Note that `callback` is a function pointer and not an `impl Fn()`.
+    /// This means that it cannot capture any variables; instead, use `plugin` to store state.
+    /// See the [impl header](crate::PluginHandle#impl-2) for more details.
+    ///
+    /// _Also_ note that passing a closure as `callback` will ICE the compiler,
+    /// due to `rustc` [bug #62529](https://github.com/rust-lang/rust/issues/62529).
+    /// A `fn` item must be used instead, as in the example below.
+    ///
+    /// Returns a [`HookHandle`](crate::hook::HookHandle) which can be passed to
+    /// [`PluginHandle::unhook`] to unregister the hook.
+    ///
+    /// Analogous to [`hexchat_hook_print_attrs`](https://hexchat.readthedocs.io/en/latest/plugins.html#c.hexchat_hook_print_attrs).
+    ///
+    /// # Examples
+    ///
+    /// ```rust
+    /// use hexavalent::PluginHandle;
+    /// use hexavalent::event::{Event, EventAttrs};
+    /// use hexavalent::event::print::YouPartWithReason;
+    /// use hexavalent::hook::{Eat, Priority};
+    ///
+    /// struct MyPlugin;
+    ///
+    /// fn hook_you_part(ph: PluginHandle<'_, MyPlugin>) {
+    ///     ph.hook_print_attrs(YouPartWithReason, Priority::Normal, you_part_cb);
+    /// }
+    ///
+    /// fn you_part_cb(
+    ///     plugin: &MyPlugin,
+    ///     ph: PluginHandle<'_, MyPlugin>,
+    ///     attrs: EventAttrs,
+    ///     args: <YouPartWithReason as Event<'_>>::Args
+    /// ) -> Eat {
+    ///     let [your_nick, your_host, channel, reason] = args;
+    ///     ph.print(&format!("You left channel {} at {}: {}.", channel, attrs.time(), reason));
+    ///     Eat::HexChat
+    /// }
+    /// ```
+    pub fn hook_print_attrs<E: PrintEvent>(
+        self,
+        event: E,
+        priority: Priority,
+        callback: fn(
+            plugin: &P,
+            ph: PluginHandle<'_, P>,
+            attrs: EventAttrs<'_>,
+            args: <E as Event<'_>>::Args,
+        ) -> Eat,
+    ) -> HookHandle {
         extern "C" fn hook_print_attrs_callback<P: 'static, E: PrintEvent>(
             word: *mut *mut c_char,
-            attrs: *mut hexchat_event_attrs,
+            attrs: *mut hexchat_event_attrs,
+            user_data: *mut c_void,
+        ) -> c_int {
+            catch_and_log_unwind("hook_print_attrs_callback", || {
+                // Safety: this is exactly the type we pass into user_data below
+                let callback: fn(
+                    plugin: &P,
+                    ph: PluginHandle<'_, P>,
+                    attrs: EventAttrs<'_>,
+                    args: <E as Event<'_>>::Args,
+                ) -> Eat = unsafe { mem::transmute(user_data) };
+
+                // Safety: attrs is a valid hexchat_event_attrs pointer
+                let timestamp = unsafe { (*attrs).server_time_utc };
+
+                // Safety: attrs is a valid hexchat_event_attrs pointer; ircv3_line is a valid string; temporary does not outlive this function
+                #[cfg(feature = "__unstable_ircv3_line_in_event_attrs")]
+                let ircv3_line = unsafe { CStr::from_ptr((*attrs).ircv3_line) }
+                    .to_str()
+                    .unwrap_or_else(|e| panic!("Invalid UTF8 from `hexchat_event_attrs`: {}", e));
+
+                let attrs = EventAttrs::new(
+                    OffsetDateTime::from_unix_timestamp(timestamp),
+                    #[cfg(feature = "__unstable_ircv3_line_in_event_attrs")]
+                    ircv3_line,
+                );
+
+                // Safety: `word` is a valid word pointer for this entire callback
+                let word = unsafe { word_to_iter(&word) };
+                let args = E::args_from_words(word, iter::empty());
+
+                with_plugin_state(|plugin, ph| callback(plugin, ph, attrs, args))
+            })
+            .unwrap_or(Eat::None) as c_int
+        }
+
+        let _ = event;
+
+        // Safety: handle is always valid
+        let hook = unsafe {
+            ((*self.handle).hexchat_hook_print_attrs)(
+                self.handle,
+                E::NAME,
+                priority as c_int,
+                hook_print_attrs_callback::<P, E>,
+                callback as *mut c_void,
+            )
+        };
+
+        let hook = NonNull::new(hook)
+            .unwrap_or_else(|| panic!("Hook handle was null, should be infallible"));
+
+        // Safety: hook was returned by HexChat; hook is not used after this
+        unsafe { HookHandle::new(hook) }
+    }
+
+    /// Registers a server event hook with HexChat.
+    ///
+    /// See the [`event::server`](crate::event::server) submodule for a list of server events.
+    ///
+    /// Note that `callback` is a function pointer and not an `impl Fn()`.
+    /// This means that it cannot capture any variables; instead, use `plugin` to store state.
+    /// See the [impl header](crate::PluginHandle#impl-2) for more details.
+    ///
+    /// _Also_ note that passing a closure as `callback` will ICE the compiler,
+    /// due to `rustc` [bug #62529](https://github.com/rust-lang/rust/issues/62529).
+    /// A `fn` item must be used instead, as in the example below.
+    ///
+    /// Returns a [`HookHandle`](crate::hook::HookHandle) which can be passed to
+    /// [`PluginHandle::unhook`] to unregister the hook.
+    ///
+    /// Analogous to [`hexchat_hook_server`](https://hexchat.readthedocs.io/en/latest/plugins.html#c.hexchat_hook_server).
+    ///
+    /// # Examples
+    ///
+    /// ```rust
+    /// use hexavalent::PluginHandle;
+    /// use hexavalent::event::Event;
+    /// use hexavalent::event::server::Part;
+    /// use hexavalent::hook::{Eat, Priority};
+    ///
+    /// struct MyPlugin;
+    ///
+    /// fn hook_part(ph: PluginHandle<'_, MyPlugin>) {
+    ///     ph.hook_server(Part, Priority::Normal, part_cb);
+    /// }
+    ///
+    /// fn part_cb(
+    ///     plugin: &MyPlugin,
+    ///     ph: PluginHandle<'_, MyPlugin>,
+    ///     args: <Part as Event<'_>>::Args
+    /// ) -> Eat {
+    ///     let [sender, _, channel, reason] = args;
+    ///     ph.print(&format!("{} left channel {}: {}.", sender, channel, reason));
+    ///     Eat::None
+    /// }
+    /// ```
+    pub fn hook_server<E: ServerEvent>(
+        self,
+        event: E,
+        priority: Priority,
+        callback: fn(plugin: &P, ph: PluginHandle<'_, P>, args: <E as Event<'_>>::Args) -> Eat,
+    ) -> HookHandle {
+        extern "C" fn hook_server_callback<P: 'static, E: ServerEvent>(
+            word: *mut *mut c_char,
+            word_eol: *mut *mut c_char,
+            user_data: *mut c_void,
+        ) -> c_int {
+            catch_and_log_unwind("hook_server_callback", || {
+                // Safety: this is exactly the type we pass into user_data below
+                let callback: fn(
+                    plugin: &P,
+                    ph: PluginHandle<'_, P>,
+                    args: <E as Event<'_>>::Args,
+                ) -> Eat = unsafe { mem::transmute(user_data) };
+
+                // Safety: `word` is a valid word pointer for this entire callback
+                let word = unsafe { word_to_iter(&word) };
+                // Safety: `word_eol` is a valid word pointer for this entire callback
+                let word_eol = unsafe { word_to_iter(&word_eol) };
+                let args = E::args_from_words(word, word_eol);
+
+                with_plugin_state(|plugin, ph| callback(plugin, ph, args))
+            })
+            .unwrap_or(Eat::None) as c_int
+        }
+
+        let _ = event;
+
+        // Safety: handle is always valid
+        let hook = unsafe {
+            ((*self.handle).hexchat_hook_server)(
+                self.handle,
+                E::NAME,
+                priority as c_int,
+                hook_server_callback::<P, E>,
+                callback as *mut c_void,
+            )
+        };
+
+        let hook = NonNull::new(hook)
+            .unwrap_or_else(|| panic!("Hook handle was null, should be infallible"));
+
+        // Safety: hook was returned by HexChat; hook is not used after this
+        unsafe { HookHandle::new(hook) }
+    }
+
+    /// Registers a server event hook with HexChat, decoding the event's arguments lazily.
+    ///
+    /// Behaves the same as [`PluginHandle::hook_server`],
+    /// but passes the arguments as a [`LazyArgs`](crate::event::LazyArgs) view
+    /// which decodes and UTF-8-validates a field only when it is accessed,
+    /// instead of eagerly converting every field up front.
+    /// Useful for hooks on high-volume events which inspect only some fields.
+    ///
+    /// Note that `callback` is a function pointer and not an `impl Fn()`.
+    /// This means that it cannot capture any variables; instead, use `plugin` to store state.
+    /// See the [impl header](crate::PluginHandle#impl-2) for more details.
+    ///
+    /// Returns a [`HookHandle`](crate::hook::HookHandle) which can be passed to
+    /// [`PluginHandle::unhook`] to unregister the hook.
+    ///
+    /// Analogous to [`hexchat_hook_server`](https://hexchat.readthedocs.io/en/latest/plugins.html#c.hexchat_hook_server).
+    ///
+    /// # Examples
+    ///
+    /// ```rust
+    /// use hexavalent::PluginHandle;
+    /// use hexavalent::event::LazyArgs;
+    /// use hexavalent::event::server::Privmsg;
+    /// use hexavalent::hook::{Eat, Priority};
+    ///
+    /// struct MyPlugin;
+    ///
+    /// fn hook_privmsg(ph: PluginHandle<'_, MyPlugin>) {
+    ///     ph.hook_server_lazy(Privmsg, Priority::Normal, privmsg_cb);
+    /// }
+    ///
+    /// fn privmsg_cb(
+    ///     plugin: &MyPlugin,
+    ///     ph: PluginHandle<'_, MyPlugin>,
+    ///     args: LazyArgs<'_, Privmsg>,
+    /// ) -> Eat {
+    ///     // only the text field (index 3) is decoded, the other fields are skipped
+    ///     if args.arg(3).contains("\x01VERSION") {
+    ///         ph.print("Received version query!");
+    ///     }
+    ///     Eat::None
+    /// }
+    /// ```
+    pub fn hook_server_lazy<E: ServerEvent>(
+        self,
+        event: E,
+        priority: Priority,
+        callback: fn(plugin: &P, ph: PluginHandle<'_, P>, args: LazyArgs<'_, E>) -> Eat,
+    ) -> HookHandle {
+        extern "C" fn hook_server_lazy_callback<P: 'static, E: ServerEvent>(
+            word: *mut *mut c_char,
+            word_eol: *mut *mut c_char,
             user_data: *mut c_void,
         ) -> c_int {
-            catch_and_log_unwind("hook_print_attrs_callback", || {
+            catch_and_log_unwind("hook_server_lazy_callback", || {
                 // Safety: this is exactly the type we pass into user_data below
                 let callback: fn(
                     plugin: &P,
                     ph: PluginHandle<'_, P>,
-                    attrs: EventAttrs<'_>,
-                    args: <E as Event<'_>>::Args,
+                    args: LazyArgs<'_, E>,
                 ) -> Eat = unsafe { mem::transmute(user_data) };
 
-                // Safety: attrs is a valid hexchat_event_attrs pointer
-                let timestamp = unsafe { (*attrs).server_time_utc };
-
-                // Safety: attrs is a valid hexchat_event_attrs pointer; ircv3_line is a valid string; temporary does not outlive this function
-                #[cfg(feature = "__unstable_ircv3_line_in_event_attrs")]
-                let ircv3_line = unsafe { CStr::from_ptr((*attrs).ircv3_line) }
-                    .to_str()
-                    .unwrap_or_else(|e| panic!("Invalid UTF8 from `hexchat_event_attrs`: {}", e));
-
-                let attrs = EventAttrs::new(
-                    OffsetDateTime::from_unix_timestamp(timestamp),
-                    #[cfg(feature = "__unstable_ircv3_line_in_event_attrs")]
-                    ircv3_line,
-                );
-
-                // Safety: `word` is a valid word pointer for this entire callback
-                let word = unsafe { word_to_iter(&word) };
-                let args = E::args_from_words(word, iter::empty());
+                // Safety: `word` and `word_eol` are valid word pointers for this entire callback
+                let args = unsafe { LazyArgs::new(word, word_eol) };
 
-                with_plugin_state(|plugin, ph| callback(plugin, ph, attrs, args))
+                with_plugin_state(|plugin, ph| callback(plugin, ph, args))
             })
             .unwrap_or(Eat::None) as c_int
         }
@@ -1178,11 +2150,11 @@ impl<'ph, P: 'static> PluginHandle<'ph, P> {
 
         // Safety: handle is always valid
         let hook = unsafe {
-            ((*self.handle).hexchat_hook_print_attrs)(
+            ((*self.handle).hexchat_hook_server)(
                 self.handle,
                 E::NAME,
                 priority as c_int,
-                hook_print_attrs_callback::<P, E>,
+                hook_server_lazy_callback::<P, E>,
                 callback as *mut c_void,
             )
         };
@@ -1194,18 +2166,25 @@ impl<'ph, P: 'static> PluginHandle<'ph, P> {
         unsafe { HookHandle::new(hook) }
     }
 
-    /// Registers a server event hook with HexChat.
+    /// Registers a server event hook with HexChat, passing the event's fields as raw bytes.
     ///
-    /// See the [`event::server`](crate::event::server) submodule for a list of server events.
+    /// Behaves the same as [`PluginHandle::hook_server`],
+    /// but passes each field to `callback` as a [`CStr`](std::ffi::CStr) borrowed directly
+    /// from HexChat, with no UTF-8 validation pass.
+    /// Decoding is opt-in per field, via [`CStr::to_str`](std::ffi::CStr::to_str)
+    /// or [`CStr::to_string_lossy`](std::ffi::CStr::to_string_lossy).
+    /// Useful for hooks that forward fields verbatim (e.g. raw logging),
+    /// or that must tolerate non-UTF-8 lines without panicking.
+    ///
+    /// Each element of `word` is a field of the event, and each element of `word_eol`
+    /// is the rest of the line starting from the corresponding field.
+    /// `word` is limited to 32 elements, and HexChat may provide excess (empty) elements,
+    /// so the length of `word` is not meaningful.
     ///
     /// Note that `callback` is a function pointer and not an `impl Fn()`.
     /// This means that it cannot capture any variables; instead, use `plugin` to store state.
     /// See the [impl header](crate::PluginHandle#impl-2) for more details.
     ///
-    /// _Also_ note that passing a closure as `callback` will ICE the compiler,
-    /// due to `rustc` [bug #62529](https://github.com/rust-lang/rust/issues/62529).
-    /// A `fn` item must be used instead, as in the example below.
-    ///
     /// Returns a [`HookHandle`](crate::hook::HookHandle) which can be passed to
     /// [`PluginHandle::unhook`] to unregister the hook.
     ///
@@ -1214,53 +2193,70 @@ impl<'ph, P: 'static> PluginHandle<'ph, P> {
     /// # Examples
     ///
     /// ```rust
+    /// use std::ffi::CStr;
     /// use hexavalent::PluginHandle;
-    /// use hexavalent::event::Event;
-    /// use hexavalent::event::server::Part;
+    /// use hexavalent::event::server::special::RawLine;
     /// use hexavalent::hook::{Eat, Priority};
     ///
     /// struct MyPlugin;
     ///
-    /// fn hook_part(ph: PluginHandle<'_, MyPlugin>) {
-    ///     ph.hook_server(Part, Priority::Normal, part_cb);
+    /// fn hook_raw_line(ph: PluginHandle<'_, MyPlugin>) {
+    ///     ph.hook_server_bytes(RawLine, Priority::Normal, raw_line_cb);
     /// }
     ///
-    /// fn part_cb(
+    /// fn raw_line_cb(
     ///     plugin: &MyPlugin,
     ///     ph: PluginHandle<'_, MyPlugin>,
-    ///     args: <Part as Event<'_>>::Args
+    ///     word: &[&CStr],
+    ///     word_eol: &[&CStr],
     /// ) -> Eat {
-    ///     let [sender, _, channel, reason] = args;
-    ///     ph.print(&format!("{} left channel {}: {}.", sender, channel, reason));
+    ///     // the line is logged byte-for-byte, even if it is not valid UTF-8
+    ///     log_bytes(word_eol[0].to_bytes());
     ///     Eat::None
     /// }
+    /// # fn log_bytes(_bytes: &[u8]) {}
     /// ```
-    pub fn hook_server<E: ServerEvent>(
+    pub fn hook_server_bytes<E: ServerEvent>(
         self,
         event: E,
         priority: Priority,
-        callback: fn(plugin: &P, ph: PluginHandle<'_, P>, args: <E as Event<'_>>::Args) -> Eat,
+        callback: fn(
+            plugin: &P,
+            ph: PluginHandle<'_, P>,
+            word: &[&CStr],
+            word_eol: &[&CStr],
+        ) -> Eat,
     ) -> HookHandle {
-        extern "C" fn hook_server_callback<P: 'static, E: ServerEvent>(
+        extern "C" fn hook_server_bytes_callback<P: 'static>(
             word: *mut *mut c_char,
             word_eol: *mut *mut c_char,
             user_data: *mut c_void,
         ) -> c_int {
-            catch_and_log_unwind("hook_server_callback", || {
+            catch_and_log_unwind("hook_server_bytes_callback", || {
                 // Safety: this is exactly the type we pass into user_data below
                 let callback: fn(
                     plugin: &P,
                     ph: PluginHandle<'_, P>,
-                    args: <E as Event<'_>>::Args,
+                    word: &[&CStr],
+                    word_eol: &[&CStr],
                 ) -> Eat = unsafe { mem::transmute(user_data) };
 
                 // Safety: `word` is a valid word pointer for this entire callback
                 let word = unsafe { word_to_iter(&word) };
                 // Safety: `word_eol` is a valid word pointer for this entire callback
                 let word_eol = unsafe { word_to_iter(&word_eol) };
-                let args = E::args_from_words(word, word_eol);
 
-                with_plugin_state(|plugin, ph| callback(plugin, ph, args))
+                let mut words = [<&CStr>::default(); 32];
+                let mut words_eol = [<&CStr>::default(); 32];
+
+                for (ws, w) in words.iter_mut().zip(word) {
+                    *ws = w;
+                }
+                for (ws, w) in words_eol.iter_mut().zip(word_eol) {
+                    *ws = w;
+                }
+
+                with_plugin_state(|plugin, ph| callback(plugin, ph, &words, &words_eol))
             })
             .unwrap_or(Eat::None) as c_int
         }
@@ -1273,7 +2269,7 @@ impl<'ph, P: 'static> PluginHandle<'ph, P> {
                 self.handle,
                 E::NAME,
                 priority as c_int,
-                hook_server_callback::<P, E>,
+                hook_server_bytes_callback::<P>,
                 callback as *mut c_void,
             )
         };
@@ -1285,6 +2281,94 @@ impl<'ph, P: 'static> PluginHandle<'ph, P> {
         unsafe { HookHandle::new(hook) }
     }
 
+    /// Registers a server event hook with HexChat, with a callback that can capture variables.
+    ///
+    /// Behaves the same as [`PluginHandle::hook_server`],
+    /// but `callback` is an `impl Fn` instead of a function pointer, so it can capture variables.
+    /// The closure is boxed once, when the hook is registered,
+    /// and dispatched by slot index afterwards, so handling an event does not allocate.
+    ///
+    /// The closure is dropped when the hook is passed to [`PluginHandle::unhook`],
+    /// or when your plugin is unloaded.
+    /// It is safe for the closure to unhook itself.
+    ///
+    /// Returns a [`HookHandle`](crate::hook::HookHandle) which can be passed to
+    /// [`PluginHandle::unhook`] to unregister the hook.
+    ///
+    /// Analogous to [`hexchat_hook_server`](https://hexchat.readthedocs.io/en/latest/plugins.html#c.hexchat_hook_server).
+    ///
+    /// # Examples
+    ///
+    /// ```rust
+    /// use hexavalent::PluginHandle;
+    /// use hexavalent::event::server::Part;
+    /// use hexavalent::hook::{Eat, Priority};
+    ///
+    /// struct MyPlugin;
+    ///
+    /// fn hook_part(ph: PluginHandle<'_, MyPlugin>, watched_channel: String) {
+    ///     ph.hook_server_with(Part, Priority::Normal, move |plugin, ph, args| {
+    ///         let [sender, _, channel, reason] = args;
+    ///         if channel == watched_channel {
+    ///             ph.print(&format!("{} left {}: {}.\0", sender, channel, reason));
+    ///         }
+    ///         Eat::None
+    ///     });
+    /// }
+    /// ```
+    pub fn hook_server_with<E, F>(self, event: E, priority: Priority, callback: F) -> HookHandle
+    where
+        E: ServerEvent,
+        F: for<'a> Fn(&P, PluginHandle<'_, P>, <E as Event<'a>>::Args) -> Eat + 'static,
+    {
+        extern "C" fn hook_server_with_callback<P: 'static, E, F>(
+            word: *mut *mut c_char,
+            word_eol: *mut *mut c_char,
+            user_data: *mut c_void,
+        ) -> c_int
+        where
+            E: ServerEvent,
+            F: for<'a> Fn(&P, PluginHandle<'_, P>, <E as Event<'a>>::Args) -> Eat + 'static,
+        {
+            catch_and_log_unwind("hook_server_with_callback", || {
+                // this is exactly the slot index we pass into user_data below
+                let slot = user_data as usize;
+
+                // Safety: `word` is a valid word pointer for this entire callback
+                let word = unsafe { word_to_iter(&word) };
+                // Safety: `word_eol` is a valid word pointer for this entire callback
+                let word_eol = unsafe { word_to_iter(&word_eol) };
+                let args = E::args_from_words(word, word_eol);
+
+                with_plugin_state(|plugin, ph| {
+                    with_closure::<F, _>(slot, |callback| callback(plugin, ph, args))
+                })
+            })
+            .unwrap_or(Eat::None) as c_int
+        }
+
+        let _ = event;
+
+        let slot = register_closure(Box::new(callback));
+
+        // Safety: handle is always valid
+        let hook = unsafe {
+            ((*self.handle).hexchat_hook_server)(
+                self.handle,
+                E::NAME,
+                priority as c_int,
+                hook_server_with_callback::<P, E, F>,
+                slot as *mut c_void,
+            )
+        };
+
+        let hook = NonNull::new(hook)
+            .unwrap_or_else(|| panic!("Hook handle was null, should be infallible"));
+
+        // Safety: hook was returned by HexChat; hook is not used after this
+        unsafe { HookHandle::new(hook) }.with_closure_slot(slot)
+    }
+
     /// Registers a server event hook with HexChat, capturing the event's attributes.
     ///
     /// See the [`event::server`](crate::event::server) submodule for a list of server events.
@@ -1496,6 +2580,90 @@ impl<'ph, P: 'static> PluginHandle<'ph, P> {
         unsafe { HookHandle::new(hook) }
     }
 
+    /// Registers a timer hook with HexChat, with a callback that can capture variables.
+    ///
+    /// Behaves the same as [`PluginHandle::hook_timer`],
+    /// but `callback` is an `impl Fn` instead of a function pointer, so it can capture variables.
+    /// The closure is boxed once, when the hook is registered,
+    /// and dispatched by slot index afterwards, so timer ticks do not allocate.
+    ///
+    /// The closure is dropped when it returns [`Timer::Stop`](crate::hook::Timer::Stop),
+    /// when the hook is passed to [`PluginHandle::unhook`], or when your plugin is unloaded.
+    /// Do not pass the returned [`HookHandle`](crate::hook::HookHandle) to [`PluginHandle::unhook`]
+    /// after the callback has returned [`Timer::Stop`](crate::hook::Timer::Stop); doing so panics.
+    ///
+    /// Analogous to [`hexchat_hook_timer`](https://hexchat.readthedocs.io/en/latest/plugins.html#c.hexchat_hook_timer).
+    ///
+    /// # Panics
+    ///
+    /// If `timeout` is more than `i32::MAX` milliseconds.
+    ///
+    /// # Examples
+    ///
+    /// ```rust
+    /// use std::time::Duration;
+    /// use hexavalent::PluginHandle;
+    /// use hexavalent::hook::Timer;
+    ///
+    /// struct MyPlugin;
+    ///
+    /// fn remind_later(ph: PluginHandle<'_, MyPlugin>, reminder: String) {
+    ///     ph.hook_timer_with(Duration::from_secs(60), move |plugin, ph| {
+    ///         ph.print(&format!("Reminder: {}\0", reminder));
+    ///         Timer::Stop
+    ///     });
+    /// }
+    /// ```
+    pub fn hook_timer_with<F>(self, timeout: Duration, callback: F) -> HookHandle
+    where
+        F: Fn(&P, PluginHandle<'_, P>) -> Timer + 'static,
+    {
+        extern "C" fn hook_timer_with_callback<P: 'static, F>(user_data: *mut c_void) -> c_int
+        where
+            F: Fn(&P, PluginHandle<'_, P>) -> Timer + 'static,
+        {
+            catch_and_log_unwind("hook_timer_with_callback", || {
+                // this is exactly the slot index we pass into user_data below
+                let slot = user_data as usize;
+
+                let timer = with_plugin_state(|plugin, ph| {
+                    with_closure::<F, _>(slot, |callback| callback(plugin, ph))
+                });
+
+                if let Timer::Stop = timer {
+                    // the timer is unregistered, so the closure can no longer be invoked
+                    free_closure(slot);
+                }
+
+                timer
+            })
+            .unwrap_or(Timer::Stop) as c_int
+        }
+
+        let milliseconds = timeout
+            .as_millis()
+            .try_into()
+            .unwrap_or_else(|e| panic!("Timeout duration too long: {}", e));
+
+        let slot = register_closure(Box::new(callback));
+
+        // Safety: handle is always valid
+        let hook = unsafe {
+            ((*self.handle).hexchat_hook_timer)(
+                self.handle,
+                milliseconds,
+                hook_timer_with_callback::<P, F>,
+                slot as *mut c_void,
+            )
+        };
+
+        let hook = NonNull::new(hook)
+            .unwrap_or_else(|| panic!("Hook handle was null, should be infallible"));
+
+        // Safety: hook was returned by HexChat; hook is not used after this
+        unsafe { HookHandle::new(hook) }.with_closure_slot(slot)
+    }
+
     /// Unregisters a hook from HexChat.
     ///
     /// Used with hook registrations functions such as [`PluginHandle::hook_command`].
@@ -1534,10 +2702,16 @@ impl<'ph, P: 'static> PluginHandle<'ph, P> {
     /// }
     /// ```
     pub fn unhook(self, hook: HookHandle) {
+        let closure_slot = hook.closure_slot();
         let hook = hook.into_raw();
 
         // Safety: handle is always valid; hook is valid due to HookHandle invariant
         let _ = unsafe { ((*self.handle).hexchat_unhook)(self.handle, hook.as_ptr()) };
+
+        // now that the hook is unregistered, its callback can no longer be invoked
+        if let Some(slot) = closure_slot {
+            free_closure(slot);
+        }
     }
 }
 
@@ -1593,13 +2767,23 @@ impl<'ph, P> PluginHandle<'ph, P> {
         let channel = channel.as_ref().map_or_else(ptr::null, |c| c.as_ptr());
 
         // Safety: handle is always valid
-        let context =
-            unsafe { ((*self.handle).hexchat_find_context)(self.handle, servname, channel) };
+        let context = stats::record("find_context", || unsafe {
+            ((*self.handle).hexchat_find_context)(self.handle, servname, channel)
+        });
 
         // Safety: context is either a valid hexchat_context pointer or null
         NonNull::new(context).map(|c| unsafe { ContextHandle::new(c) })
     }
 
+    /// The raw current context pointer.
+    ///
+    /// Used by [`ContextCache`](crate::context::ContextCache) to key
+    /// [`Context::Nearby`] resolutions, which depend on the current server.
+    pub(crate) fn raw_context(self) -> Option<NonNull<hexchat_context>> {
+        // Safety: handle is always valid
+        NonNull::new(unsafe { ((*self.handle).hexchat_get_context)(self.handle) })
+    }
+
     /// Executes a function in a different server/channel context.
     ///
     /// Used with [`PluginHandle::find_context`].
@@ -1648,6 +2832,60 @@ impl<'ph, P> PluginHandle<'ph, P> {
 
         f()
     }
+
+    /// Enters a different server/channel context until the returned guard is dropped.
+    ///
+    /// Behaves like [`PluginHandle::with_context`], but scoped to a guard instead of a closure.
+    /// While the [`ContextGuard`](crate::context::ContextGuard) is alive,
+    /// all operations on this plugin handle run in the entered context;
+    /// dropping the guard restores the previous context.
+    /// This pays one `hexchat_set_context` pair for an arbitrarily long batch of operations,
+    /// where a [`PluginHandle::with_context`] call per operation would pay one pair each.
+    ///
+    /// Guards restore contexts in reverse creation order as they go out of scope,
+    /// so nested guards behave like nested [`PluginHandle::with_context`] calls.
+    ///
+    /// Analogous to [`hexchat_get_context`](https://hexchat.readthedocs.io/en/latest/plugins.html#c.hexchat_get_context) and
+    /// [`hexchat_set_context`](https://hexchat.readthedocs.io/en/latest/plugins.html#c.hexchat_set_context).
+    ///
+    /// # Examples
+    ///
+    /// ```rust
+    /// use hexavalent::PluginHandle;
+    /// use hexavalent::context::Context;
+    ///
+    /// fn relay_messages_to_channel<P>(
+    ///     ph: PluginHandle<'_, P>,
+    ///     channel: &str,
+    ///     messages: &[&str],
+    /// ) -> Result<(), ()> {
+    ///     let ctxt = match ph.find_context(Context::Nearby { channel }) {
+    ///         Some(ctxt) => ctxt,
+    ///         None => return Err(()),
+    ///     };
+    ///     let _guard = ph.enter_context(ctxt);
+    ///     for message in messages {
+    ///         // one context switch pair for the whole batch, not one per message
+    ///         ph.print(message);
+    ///     }
+    ///     Ok(())
+    /// }
+    /// ```
+    pub fn enter_context(self, context: ContextHandle<'_>) -> ContextGuard<'ph> {
+        // Safety: handle is always valid
+        let old_context = unsafe { ((*self.handle).hexchat_get_context)(self.handle) };
+
+        // Safety: handle is always valid; context contains a valid pointer
+        int_to_result(unsafe {
+            ((*self.handle).hexchat_set_context)(self.handle, context.as_ptr().as_ptr())
+        })
+        // this should be infallible, since the lifetime on ContextHandle prevents it from being stored,
+        // and it should not be invalidated while our code is running
+        .unwrap_or_else(|_| panic!("Channel invalidated while plugin running"));
+
+        // Safety: handle is always valid for 'ph; old_context is a valid pointer
+        unsafe { ContextGuard::new(self.handle, old_context) }
+    }
 }
 
 /// [Plugin Preferences](https://hexchat.readthedocs.io/en/latest/plugins.html#plugin-preferences)
@@ -1681,8 +2919,14 @@ impl<'ph, P> PluginHandle<'ph, P> {
         }
 
         // Safety: handle is always valid
-        int_to_result(unsafe {
-            ((*self.handle).hexchat_pluginpref_set_str)(self.handle, name.as_ptr(), value.as_ptr())
+        stats::record("pluginpref_set_str", || {
+            int_to_result(unsafe {
+                ((*self.handle).hexchat_pluginpref_set_str)(
+                    self.handle,
+                    name.as_ptr(),
+                    value.as_ptr(),
+                )
+            })
         })
     }
 
@@ -1740,12 +2984,14 @@ impl<'ph, P> PluginHandle<'ph, P> {
 
         // Safety: handle is always valid
         // (Un)Safety: no length argument, better hope they never change the 512 max length
-        let res = int_to_result(unsafe {
-            ((*self.handle).hexchat_pluginpref_get_str)(
-                self.handle,
-                name.as_ptr(),
-                buf.as_mut_ptr(),
-            )
+        let res = stats::record("pluginpref_get_str", || {
+            int_to_result(unsafe {
+                ((*self.handle).hexchat_pluginpref_get_str)(
+                    self.handle,
+                    name.as_ptr(),
+                    buf.as_mut_ptr(),
+                )
+            })
         });
 
         if let Err(()) = res {
@@ -1780,8 +3026,10 @@ impl<'ph, P> PluginHandle<'ph, P> {
         let name = name.into_cstr();
 
         // Safety: handle is always valid
-        int_to_result(unsafe {
-            ((*self.handle).hexchat_pluginpref_set_int)(self.handle, name.as_ptr(), value)
+        stats::record("pluginpref_set_int", || {
+            int_to_result(unsafe {
+                ((*self.handle).hexchat_pluginpref_set_int)(self.handle, name.as_ptr(), value)
+            })
         })
     }
 
@@ -1803,8 +3051,9 @@ impl<'ph, P> PluginHandle<'ph, P> {
         let name = name.into_cstr();
 
         // Safety: handle is always valid
-        let value =
-            unsafe { ((*self.handle).hexchat_pluginpref_get_int)(self.handle, name.as_ptr()) };
+        let value = stats::record("pluginpref_get_int", || unsafe {
+            ((*self.handle).hexchat_pluginpref_get_int)(self.handle, name.as_ptr())
+        });
 
         match value {
             -1 => Err(()),
@@ -1831,8 +3080,10 @@ impl<'ph, P> PluginHandle<'ph, P> {
         let name = name.into_cstr();
 
         // Safety: handle is always valid
-        int_to_result(unsafe {
-            ((*self.handle).hexchat_pluginpref_delete)(self.handle, name.as_ptr())
+        stats::record("pluginpref_delete", || {
+            int_to_result(unsafe {
+                ((*self.handle).hexchat_pluginpref_delete)(self.handle, name.as_ptr())
+            })
         })
     }
 
@@ -1910,8 +3161,10 @@ impl<'ph, P> PluginHandle<'ph, P> {
         let mut buf = [0; 4096];
 
         // Safety: handle is always valid
-        let res = int_to_result(unsafe {
-            ((*self.handle).hexchat_pluginpref_list)(self.handle, buf.as_mut_ptr())
+        let res = stats::record("pluginpref_list", || {
+            int_to_result(unsafe {
+                ((*self.handle).hexchat_pluginpref_list)(self.handle, buf.as_mut_ptr())
+            })
         });
 
         if let Err(()) = res {
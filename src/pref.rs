@@ -1,5 +1,15 @@
 //! Global preferences.
 
+use std::any::Any;
+use std::cell::{Cell, RefCell};
+use std::collections::HashMap;
+use std::fmt;
+
+use std::time::Duration;
+
+use crate::hook::{Eat, HookHandle, Priority, Timer};
+use crate::plugin::PluginHandle;
+
 /// The value of a HexChat setting.
 ///
 /// Used with [`PluginHandle::get_pref`](crate::PluginHandle::get_pref).
@@ -99,3 +109,380 @@ pub use impls::*;
 ///
 /// Analogous to the special preferences documented for [`hexchat_get_prefs`](https://hexchat.readthedocs.io/en/latest/plugins.html#c.hexchat_get_prefs).
 pub mod special;
+
+/// A generation-counted cache over global preference reads.
+///
+/// [`PluginHandle::get_pref`](crate::PluginHandle::get_pref) crosses the FFI boundary
+/// and re-parses the returned value on every read,
+/// which adds up when per-message hooks consult the same settings hundreds of times per second.
+/// A `PrefCache` reads each preference once per generation, then answers from memory;
+/// bumping the generation with [`PrefCache::invalidate`] lazily discards every cached value.
+///
+/// [`PluginHandle::hook_pref_cache`] hooks the `/set` command to invalidate automatically
+/// when the user changes a setting.
+/// Preferences changed by other means (e.g. the settings dialog) are not detected;
+/// call [`PrefCache::invalidate`] yourself if you need to observe such changes promptly.
+///
+/// To use it, store a `PrefCache` in your plugin, implement `AsRef<PrefCache>`,
+/// and call [`PluginHandle::hook_pref_cache`] in [`Plugin::init`](crate::Plugin::init).
+/// See [`PluginHandle::hook_pref_cache`] for an example.
+#[derive(Default)]
+pub struct PrefCache {
+    /// Map from preference name (a static pointer, so usable as an identity key)
+    /// to the generation it was read in and its value.
+    values: RefCell<HashMap<usize, (u64, Box<dyn Any>)>>,
+    /// Bumped by `invalidate` to lazily discard every cached value.
+    generation: Cell<u64>,
+}
+
+impl fmt::Debug for PrefCache {
+    fn fmt(&self, f: &mut fmt::Formatter<'_>) -> fmt::Result {
+        f.debug_struct("PrefCache")
+            .field("entries", &self.values.borrow().len())
+            .field("generation", &self.generation.get())
+            .finish()
+    }
+}
+
+impl PrefCache {
+    /// Creates a new, empty `PrefCache`.
+    pub fn new() -> Self {
+        Self::default()
+    }
+
+    /// Gets a global preference, reading through to HexChat only on the first call per generation.
+    ///
+    /// Analogous to [`PluginHandle::get_pref`](crate::PluginHandle::get_pref).
+    /// Failed reads are not cached.
+    pub fn get<P, Pr>(&self, ph: PluginHandle<'_, P>, pref: Pr) -> Result<<Pr as Pref>::Type, ()>
+    where
+        Pr: Pref,
+        <Pr as Pref>::Type: Clone + 'static,
+    {
+        let key = <Pr as private::PrefImpl>::NAME as usize;
+        let generation = self.generation.get();
+
+        if let Some(&(cached_generation, ref value)) = self.values.borrow().get(&key) {
+            if cached_generation == generation {
+                let value = value
+                    .downcast_ref::<<Pr as Pref>::Type>()
+                    .unwrap_or_else(|| panic!("Cached preference value is an unexpected type"));
+                return Ok(value.clone());
+            }
+        }
+
+        let value = ph.get_pref(pref)?;
+        self.values
+            .borrow_mut()
+            .insert(key, (generation, Box::new(value.clone())));
+        Ok(value)
+    }
+
+    /// Discards every cached value, so that the next read of each preference is fresh.
+    pub fn invalidate(&self) {
+        self.generation.set(self.generation.get() + 1);
+    }
+}
+
+/// [Preference Caching](crate::pref::PrefCache)
+///
+/// Allows your plugin to cache global preference reads.
+impl<'ph, P: 'static + AsRef<PrefCache>> PluginHandle<'ph, P> {
+    /// Registers the `/set` command hook keeping your plugin's [`PrefCache`] honest.
+    ///
+    /// The hook does not eat the command; it only invalidates the cache,
+    /// so that reads after a `/set` observe the new value.
+    ///
+    /// Call this once from [`Plugin::init`](crate::Plugin::init).
+    ///
+    /// Returns a [`HookHandle`](crate::hook::HookHandle) which can be passed to
+    /// [`PluginHandle::unhook`](crate::PluginHandle::unhook) to stop invalidating.
+    ///
+    /// # Examples
+    ///
+    /// ```rust
+    /// use hexavalent::{Plugin, PluginHandle};
+    /// use hexavalent::pref::{IrcNick1, PrefCache};
+    ///
+    /// #[derive(Default)]
+    /// struct MyPlugin {
+    ///     prefs: PrefCache,
+    /// }
+    ///
+    /// impl AsRef<PrefCache> for MyPlugin {
+    ///     fn as_ref(&self) -> &PrefCache {
+    ///         &self.prefs
+    ///     }
+    /// }
+    ///
+    /// impl Plugin for MyPlugin {
+    ///     fn init(&self, ph: PluginHandle<'_, Self>) {
+    ///         ph.hook_pref_cache();
+    ///     }
+    /// }
+    ///
+    /// fn check_message(plugin: &MyPlugin, ph: PluginHandle<'_, MyPlugin>) {
+    ///     // only the first read per generation crosses the FFI boundary
+    ///     let nick = plugin.prefs.get(ph, IrcNick1);
+    /// }
+    /// ```
+    pub fn hook_pref_cache(self) -> HookHandle {
+        self.hook_command("set\0", "\0", Priority::Highest, |plugin, _ph, _words| {
+            plugin.as_ref().invalidate();
+            Eat::None
+        })
+    }
+}
+
+/// The pending value of a plugin preference.
+#[derive(Debug, Clone)]
+enum PluginPrefValue {
+    Str(String),
+    Int(i32),
+}
+
+/// A write-behind layer over plugin preference persistence.
+///
+/// [`PluginHandle::pluginpref_set_str`](crate::PluginHandle::pluginpref_set_str) and
+/// [`PluginHandle::pluginpref_set_int`](crate::PluginHandle::pluginpref_set_int)
+/// rewrite the plugin's config file on every call,
+/// so checkpointing dozens of constantly-updated counters is dominated by file rewrites.
+/// A `PluginPrefs` instead records sets in an in-memory dirty map,
+/// and a coalescing [`flush`](PluginPrefs::flush) writes each dirty key once,
+/// so a thousand logical updates between flushes cost at most one file rewrite per key.
+///
+/// Reads check the dirty map first, so a set is always visible to a later get,
+/// even before it is flushed.
+///
+/// To use it, store a `PluginPrefs` in your plugin, implement `AsRef<PluginPrefs>`,
+/// call [`PluginHandle::hook_pluginpref_flush`] in [`Plugin::init`](crate::Plugin::init),
+/// and — important — call [`flush`](PluginPrefs::flush) in [`Plugin::deinit`](crate::Plugin::deinit),
+/// as pending sets are otherwise lost when the plugin unloads.
+/// See [`PluginHandle::hook_pluginpref_flush`] for an example.
+#[derive(Debug, Default)]
+pub struct PluginPrefs {
+    /// Sets awaiting flush, by preference name.
+    dirty: RefCell<HashMap<String, PluginPrefValue>>,
+}
+
+impl PluginPrefs {
+    /// Creates a new `PluginPrefs` with nothing to flush.
+    pub fn new() -> Self {
+        Self::default()
+    }
+
+    /// Sets a plugin-specific string preference, deferred until the next flush.
+    ///
+    /// Analogous to [`PluginHandle::pluginpref_set_str`](crate::PluginHandle::pluginpref_set_str),
+    /// including failing on values longer than HexChat's 511-byte limit.
+    /// Also fails on interior null bytes, which would panic during the flush
+    /// (where there is nobody to report the failure to).
+    pub fn set_str(&self, name: &str, value: &str) -> Result<(), ()> {
+        let name = name.trim_end_matches('\0');
+        let value = value.trim_end_matches('\0');
+
+        // mirror the limit in `pluginpref_set_str`, so that failure surfaces at the set
+        // (by flush time there is nobody to report it to); likewise reject interior nulls,
+        // which `into_cstr` would panic on during the flush
+        if value.len() + 1 > 512 || name.contains('\0') || value.contains('\0') {
+            return Err(());
+        }
+
+        self.dirty
+            .borrow_mut()
+            .insert(name.to_owned(), PluginPrefValue::Str(value.to_owned()));
+        Ok(())
+    }
+
+    /// Sets a plugin-specific int preference, deferred until the next flush.
+    ///
+    /// Analogous to [`PluginHandle::pluginpref_set_int`](crate::PluginHandle::pluginpref_set_int).
+    /// Fails on interior null bytes in `name`, which would panic during the flush
+    /// (where there is nobody to report the failure to).
+    pub fn set_int(&self, name: &str, value: i32) -> Result<(), ()> {
+        let name = name.trim_end_matches('\0');
+
+        // as in `set_str`, interior nulls would panic during the flush
+        if name.contains('\0') {
+            return Err(());
+        }
+
+        self.dirty
+            .borrow_mut()
+            .insert(name.to_owned(), PluginPrefValue::Int(value));
+        Ok(())
+    }
+
+    /// Gets a plugin-specific string preference.
+    ///
+    /// Pending sets are visible even before they are flushed.
+    ///
+    /// Analogous to [`PluginHandle::pluginpref_get_str`](crate::PluginHandle::pluginpref_get_str).
+    pub fn get_str<P>(&self, ph: PluginHandle<'_, P>, name: &str) -> Result<String, ()> {
+        match self.dirty.borrow().get(name.trim_end_matches('\0')) {
+            Some(PluginPrefValue::Str(value)) => return Ok(value.clone()),
+            // int preferences can be loaded as strings, as with `pluginpref_get_str`
+            Some(PluginPrefValue::Int(value)) => return Ok(value.to_string()),
+            None => {}
+        }
+        ph.pluginpref_get_str(name)
+    }
+
+    /// Gets a plugin-specific int preference.
+    ///
+    /// Pending sets are visible even before they are flushed.
+    ///
+    /// Analogous to [`PluginHandle::pluginpref_get_int`](crate::PluginHandle::pluginpref_get_int).
+    pub fn get_int<P>(&self, ph: PluginHandle<'_, P>, name: &str) -> Result<i32, ()> {
+        match self.dirty.borrow().get(name.trim_end_matches('\0')) {
+            Some(PluginPrefValue::Int(value)) => return Ok(*value),
+            Some(PluginPrefValue::Str(value)) => return value.parse().map_err(|_| ()),
+            None => {}
+        }
+        ph.pluginpref_get_int(name)
+    }
+
+    /// Writes every dirty preference to HexChat, each key once.
+    ///
+    /// Called automatically by the timer registered with [`PluginHandle::hook_pluginpref_flush`];
+    /// call it directly from [`Plugin::deinit`](crate::Plugin::deinit),
+    /// and on any other path that must not lose pending sets.
+    ///
+    /// Keys that fail to write stay dirty (and are retried by the next flush); returns `Err` if any did.
+    pub fn flush<P>(&self, ph: PluginHandle<'_, P>) -> Result<(), ()> {
+        // take the dirty map out, so this `PluginPrefs` is not borrowed during FFI calls
+        let dirty = std::mem::take(&mut *self.dirty.borrow_mut());
+
+        let mut result = Ok(());
+        for (name, value) in dirty {
+            let written = match &value {
+                PluginPrefValue::Str(str) => ph.pluginpref_set_str(&name, str),
+                PluginPrefValue::Int(int) => ph.pluginpref_set_int(&name, *int),
+            };
+            if written.is_err() {
+                result = Err(());
+                // keep the failed set dirty, unless it was overwritten mid-flush
+                self.dirty.borrow_mut().entry(name).or_insert(value);
+            }
+        }
+        result
+    }
+}
+
+/// [Plugin Preference Batching](crate::pref::PluginPrefs)
+///
+/// Allows your plugin to coalesce plugin preference writes.
+impl<'ph, P: 'static + AsRef<PluginPrefs>> PluginHandle<'ph, P> {
+    /// Registers the HexChat timer flushing your plugin's [`PluginPrefs`].
+    ///
+    /// Every `interval`, all dirty preferences are written, each key once.
+    /// Also call [`PluginPrefs::flush`] from [`Plugin::deinit`](crate::Plugin::deinit),
+    /// as pending sets are otherwise lost when the plugin unloads.
+    ///
+    /// Call this once from [`Plugin::init`](crate::Plugin::init).
+    ///
+    /// Returns a [`HookHandle`](crate::hook::HookHandle) which can be passed to
+    /// [`PluginHandle::unhook`](crate::PluginHandle::unhook) to stop flushing entirely.
+    ///
+    /// # Examples
+    ///
+    /// ```rust
+    /// use std::time::Duration;
+    /// use hexavalent::{Plugin, PluginHandle};
+    /// use hexavalent::pref::PluginPrefs;
+    ///
+    /// #[derive(Default)]
+    /// struct MyPlugin {
+    ///     prefs: PluginPrefs,
+    /// }
+    ///
+    /// impl AsRef<PluginPrefs> for MyPlugin {
+    ///     fn as_ref(&self) -> &PluginPrefs {
+    ///         &self.prefs
+    ///     }
+    /// }
+    ///
+    /// impl Plugin for MyPlugin {
+    ///     fn init(&self, ph: PluginHandle<'_, Self>) {
+    ///         ph.hook_pluginpref_flush(Duration::from_secs(10));
+    ///     }
+    ///
+    ///     fn deinit(&self, ph: PluginHandle<'_, Self>) {
+    ///         let _ = self.prefs.flush(ph);
+    ///     }
+    /// }
+    ///
+    /// fn checkpoint_counter(plugin: &MyPlugin, channel: &str, count: i32) {
+    ///     // cheap no matter how often it is called; the file is rewritten at most once per flush
+    ///     let _ = plugin.prefs.set_int(channel, count);
+    /// }
+    /// ```
+    pub fn hook_pluginpref_flush(self, interval: Duration) -> HookHandle {
+        self.hook_timer(interval, |plugin, ph| {
+            let _ = plugin.as_ref().flush(ph);
+            Timer::Continue
+        })
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use std::ptr;
+
+    use super::*;
+
+    #[test]
+    fn pending_sets_are_readable_before_flush() {
+        // Safety: the handle is only used for dirty-map hits, which never call HexChat
+        let ph = unsafe { PluginHandle::<'_, ()>::new(ptr::null_mut()) };
+        let prefs = PluginPrefs::new();
+
+        assert_eq!(prefs.set_int("counter\0", 7), Ok(()));
+        assert_eq!(prefs.set_str("motd", "hello"), Ok(()));
+
+        assert_eq!(prefs.get_int(ph, "counter"), Ok(7));
+        assert_eq!(prefs.get_str(ph, "motd\0"), Ok(String::from("hello")));
+        // int preferences can be loaded as strings, and vice versa
+        assert_eq!(prefs.get_str(ph, "counter"), Ok(String::from("7")));
+
+        // repeated sets coalesce into one dirty entry
+        assert_eq!(prefs.set_int("counter", 8), Ok(()));
+        assert_eq!(prefs.dirty.borrow().len(), 2);
+    }
+
+    #[test]
+    fn overlong_values_are_rejected_at_set() {
+        let prefs = PluginPrefs::new();
+        assert_eq!(prefs.set_str("key", &"x".repeat(512)), Err(()));
+        assert!(prefs.dirty.borrow().is_empty());
+    }
+
+    #[test]
+    fn interior_nulls_are_rejected_at_set() {
+        let prefs = PluginPrefs::new();
+        // a panic inside the flush timer callback could not be reported to anyone
+        assert_eq!(prefs.set_str("ke\0y", "value"), Err(()));
+        assert_eq!(prefs.set_str("key", "val\0ue"), Err(()));
+        assert_eq!(prefs.set_int("ke\0y", 7), Err(()));
+        assert!(prefs.dirty.borrow().is_empty());
+    }
+
+    #[test]
+    fn cache_hits_skip_hexchat_and_invalidate_discards() {
+        // Safety: the handle is only used for cache hits, which never call HexChat
+        let ph = unsafe { PluginHandle::<'_, ()>::new(ptr::null_mut()) };
+        let cache = PrefCache::new();
+
+        let key = <IrcNick1 as private::PrefImpl>::NAME as usize;
+        cache
+            .values
+            .borrow_mut()
+            .insert(key, (0, Box::new(String::from("somenick"))));
+
+        assert_eq!(cache.get(ph, IrcNick1), Ok(String::from("somenick")));
+
+        cache.invalidate();
+        let (generation, _) = cache.values.borrow()[&key];
+        assert_ne!(generation, cache.generation.get());
+    }
+}
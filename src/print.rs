@@ -0,0 +1,200 @@
+//! Buffered printing.
+
+use std::cell::RefCell;
+use std::collections::HashMap;
+use std::mem;
+use std::time::Duration;
+
+use crate::ffi::hexchat_context;
+use crate::hook::{HookHandle, Timer};
+use crate::plugin::PluginHandle;
+
+/// A sink that coalesces printed lines into one flush per context per tick.
+///
+/// [`PluginHandle::print`](crate::PluginHandle::print) makes one FFI call per line,
+/// and HexChat re-renders after each, so relaying a burst of hundreds of lines
+/// stalls the UI for the duration.
+/// A `PrintBuffer` instead appends each line to a per-context buffer (one allocation, reused),
+/// and an internally-registered timer flushes each context's lines
+/// in a single `hexchat_print` call per tick,
+/// turning burst printing from O(lines) FFI calls and redraws into O(ticks).
+///
+/// Lines land in the context that was current when they were printed,
+/// so buffered printing pairs with [`PluginHandle::with_context`](crate::PluginHandle::with_context)
+/// the same way [`PluginHandle::print`](crate::PluginHandle::print) does.
+/// Lines whose context is closed before the next flush are dropped.
+///
+/// To use it, store a `PrintBuffer` in your plugin, implement `AsRef<PrintBuffer>`,
+/// and call [`PluginHandle::hook_print_buffer`] in [`Plugin::init`](crate::Plugin::init).
+/// See [`PluginHandle::hook_print_buffer`] for an example.
+#[derive(Debug, Default)]
+pub struct PrintBuffer {
+    /// Map from context to its buffered lines, separated by `'\n'`.
+    ///
+    /// Entries persist across flushes (with their capacity) until their context closes.
+    buffers: RefCell<HashMap<*mut hexchat_context, String>>,
+}
+
+impl PrintBuffer {
+    /// Creates a new, empty `PrintBuffer`.
+    pub fn new() -> Self {
+        Self::default()
+    }
+
+    /// Prints text to the current context, at the next flush.
+    ///
+    /// Analogous to [`PluginHandle::print`](crate::PluginHandle::print), including accepting
+    /// (and ignoring) a trailing null terminator, but deferred until the next flush.
+    ///
+    /// # Panics
+    ///
+    /// If `text` contains an interior null byte.
+    pub fn print<P>(&self, ph: PluginHandle<'_, P>, text: &str) {
+        // Safety: handle is always valid
+        let context = unsafe { ((*ph.handle).hexchat_get_context)(ph.handle) };
+        self.append(context, text);
+    }
+
+    /// Appends `text` to one context's buffer.
+    fn append(&self, context: *mut hexchat_context, text: &str) {
+        let text = text.strip_suffix('\0').unwrap_or(text);
+        assert!(
+            !text.as_bytes().contains(&0),
+            "Interior null byte in printed text: {:?}",
+            text
+        );
+
+        let mut buffers = self.buffers.borrow_mut();
+        let buf = buffers.entry(context).or_default();
+        if !buf.is_empty() {
+            buf.push('\n');
+        }
+        buf.push_str(text);
+    }
+
+    /// Prints every buffered line, one FFI call per context with pending lines.
+    ///
+    /// Called automatically by the timer registered with [`PluginHandle::hook_print_buffer`];
+    /// call it directly on latency-sensitive paths that cannot wait for the next tick.
+    pub fn flush<P>(&self, ph: PluginHandle<'_, P>) {
+        // take the pending buffers out, so this `PrintBuffer` is not borrowed during FFI calls
+        let pending: Vec<_> = {
+            let mut buffers = self.buffers.borrow_mut();
+            buffers
+                .iter_mut()
+                .filter(|(_, buf)| !buf.is_empty())
+                .map(|(&context, buf)| (context, mem::take(buf)))
+                .collect()
+        };
+
+        if pending.is_empty() {
+            return;
+        }
+
+        // Safety: handle is always valid
+        let prev_context = unsafe { ((*ph.handle).hexchat_get_context)(ph.handle) };
+
+        for (context, mut buf) in pending {
+            // Safety: handle is always valid; a stale `context` is rejected, not dereferenced
+            let entered = unsafe { ((*ph.handle).hexchat_set_context)(ph.handle, context) };
+            if entered == 0 {
+                // the context was closed since its lines were buffered; drop them
+                self.buffers.borrow_mut().remove(&context);
+                continue;
+            }
+
+            buf.push('\0');
+            // Safety: handle is always valid; `buf` is null-terminated
+            unsafe { ((*ph.handle).hexchat_print)(ph.handle, buf.as_ptr().cast()) };
+            buf.clear();
+
+            // return the buffer (keeping its capacity) for reuse
+            self.buffers.borrow_mut().insert(context, buf);
+        }
+
+        // the original context may itself have closed mid-flush; nothing to do about that here
+        // Safety: handle is always valid
+        let _ = unsafe { ((*ph.handle).hexchat_set_context)(ph.handle, prev_context) };
+    }
+}
+
+/// [Buffered Printing](crate::print::PrintBuffer)
+///
+/// Allows your plugin to coalesce burst output into one flush per tick.
+impl<'ph, P: 'static + AsRef<PrintBuffer>> PluginHandle<'ph, P> {
+    /// Registers the HexChat timer flushing your plugin's [`PrintBuffer`].
+    ///
+    /// Every `resolution`, all buffered lines are printed,
+    /// with one FFI call per context with pending lines.
+    ///
+    /// Call this once from [`Plugin::init`](crate::Plugin::init).
+    ///
+    /// Returns a [`HookHandle`](crate::hook::HookHandle) which can be passed to
+    /// [`PluginHandle::unhook`](crate::PluginHandle::unhook) to stop flushing entirely.
+    ///
+    /// # Examples
+    ///
+    /// ```rust
+    /// use std::time::Duration;
+    /// use hexavalent::{Plugin, PluginHandle};
+    /// use hexavalent::print::PrintBuffer;
+    ///
+    /// #[derive(Default)]
+    /// struct MyPlugin {
+    ///     output: PrintBuffer,
+    /// }
+    ///
+    /// impl AsRef<PrintBuffer> for MyPlugin {
+    ///     fn as_ref(&self) -> &PrintBuffer {
+    ///         &self.output
+    ///     }
+    /// }
+    ///
+    /// impl Plugin for MyPlugin {
+    ///     fn init(&self, ph: PluginHandle<'_, Self>) {
+    ///         ph.hook_print_buffer(Duration::from_millis(50));
+    ///     }
+    /// }
+    ///
+    /// fn relay_burst(plugin: &MyPlugin, ph: PluginHandle<'_, MyPlugin>, lines: &[&str]) {
+    ///     for line in lines {
+    ///         plugin.output.print(ph, line);
+    ///     }
+    ///     // all lines print together, at the next flush
+    /// }
+    /// ```
+    pub fn hook_print_buffer(self, resolution: Duration) -> HookHandle {
+        self.hook_timer(resolution, |plugin, ph| {
+            plugin.as_ref().flush(ph);
+            Timer::Continue
+        })
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    fn fake_context(id: usize) -> *mut hexchat_context {
+        id as *mut hexchat_context
+    }
+
+    #[test]
+    fn lines_coalesce_per_context() {
+        let buffer = PrintBuffer::new();
+
+        buffer.append(fake_context(1), "one");
+        buffer.append(fake_context(1), "two\0");
+        buffer.append(fake_context(2), "three");
+
+        let buffers = buffer.buffers.borrow();
+        assert_eq!(buffers[&fake_context(1)], "one\ntwo");
+        assert_eq!(buffers[&fake_context(2)], "three");
+    }
+
+    #[test]
+    #[should_panic]
+    fn interior_null_rejected() {
+        PrintBuffer::new().append(fake_context(1), "one\0two");
+    }
+}
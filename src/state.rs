@@ -1,7 +1,8 @@
-use std::any::Any;
+use std::any::{Any, TypeId};
 use std::cell::UnsafeCell;
+use std::fmt::{self, Write};
 use std::ops::Deref;
-use std::os::raw::c_int;
+use std::os::raw::{c_char, c_int};
 use std::panic::{catch_unwind, UnwindSafe};
 use std::process;
 use std::ptr;
@@ -14,54 +15,157 @@ use crate::plugin::{Plugin, PluginHandle};
 /// Plugin handle used to log caught panics, when the normal (safe) plugin context might not be available.
 static LAST_RESORT_PLUGIN_HANDLE: AtomicPtr<hexchat_plugin> = AtomicPtr::new(ptr::null_mut());
 
+/// Fixed-size buffer that panic messages are formatted into, truncating on overflow.
+///
+/// One byte of capacity is always reserved for the null terminator added by [`as_c_ptr`](Self::as_c_ptr).
+struct PanicMsgBuffer {
+    buf: [u8; Self::CAPACITY],
+    len: usize,
+}
+
+impl PanicMsgBuffer {
+    const CAPACITY: usize = 1024;
+
+    const fn new() -> Self {
+        Self {
+            buf: [0; Self::CAPACITY],
+            len: 0,
+        }
+    }
+
+    fn clear(&mut self) {
+        self.len = 0;
+    }
+
+    /// Null-terminates the buffer and returns it as a C-style string.
+    fn as_c_ptr(&mut self) -> *const c_char {
+        self.buf[self.len] = 0;
+        self.buf.as_ptr().cast()
+    }
+}
+
+impl Write for PanicMsgBuffer {
+    fn write_str(&mut self, s: &str) -> fmt::Result {
+        let remaining = (Self::CAPACITY - 1) - self.len;
+        let mut truncated_len = s.len().min(remaining);
+        while !s.is_char_boundary(truncated_len) {
+            truncated_len -= 1;
+        }
+        self.buf[self.len..self.len + truncated_len]
+            .copy_from_slice(&s.as_bytes()[..truncated_len]);
+        self.len += truncated_len;
+        Ok(())
+    }
+}
+
+/// Preallocated storage for the panic message reported to HexChat,
+/// so that reporting a panic performs no allocation
+/// (a panic caused by allocation failure could otherwise abort while being reported).
+static PANIC_MSG: ExtSync<PanicMsgBuffer> = ExtSync(UnsafeCell::new(PanicMsgBuffer::new()));
+
+/// Logs a caught panic to stderr and to HexChat.
+///
+/// Outlined and marked cold so that `catch_and_log_unwind`'s happy path
+/// is a straight call with no panic-formatting machinery inlined into every trampoline.
+///
+/// Warning: if `LAST_RESORT_PLUGIN_HANDLE` is not defined, this function will abort the process.
+#[cold]
+#[inline(never)]
+fn log_caught_unwind(ctxt_msg: &'static str, panic: &(dyn Any + Send)) {
+    fn abort_process_due_to_panic_without_plugin_handle() -> ! {
+        process::abort()
+    }
+
+    let panic_msg = if let Some(s) = panic.downcast_ref::<String>() {
+        s.as_str()
+    } else if let Some(s) = panic.downcast_ref::<&'static str>() {
+        s
+    } else {
+        "<unknown>"
+    };
+
+    eprintln!(
+        "WARNING: `hexavalent` caught panic (in `{}`): {}",
+        ctxt_msg, panic_msg
+    );
+
+    let plugin_handle = LAST_RESORT_PLUGIN_HANDLE.load(Ordering::Relaxed);
+    if plugin_handle.is_null() {
+        eprintln!("FATAL: `hexavalent` cannot find a plugin context");
+        abort_process_due_to_panic_without_plugin_handle()
+    }
+
+    // Safety: this borrow is released before this function returns,
+    // and formatting `&str`s cannot reenter this function
+    let message = unsafe { &mut *PANIC_MSG.get() };
+    message.clear();
+    let _ = write!(
+        message,
+        "WARNING: `hexavalent` caught panic (in `{}`): {}",
+        ctxt_msg, panic_msg
+    );
+
+    // Safety: as_c_ptr null-terminates the message
+    // (Un)Safety: plugin_handle may not be valid, but there's nothing we can do here
+    unsafe { ((*plugin_handle).hexchat_print)(plugin_handle, message.as_c_ptr()) }
+}
+
 /// Runs a closure under `catch_unwind` and logs the panic using `hexchat_print` if it happens.
 ///
+/// Also times the closure under `ctxt_msg`'s histogram
+/// when the `__unstable_call_stats` feature is enabled,
+/// covering every hook callback dispatched through this function.
+///
+/// By default the logger runs under a second `catch_unwind`, and the process aborts if it panics.
+/// The `__unstable_single_catch_unwind` feature removes the second catch,
+/// replacing it with a drop guard that aborts if the logger unwinds,
+/// so the happy path carries only a single unwind guard.
+///
 /// Warning: if `LAST_RESORT_PLUGIN_HANDLE` is not defined when a panic happens, this function will abort the process.
 pub(crate) fn catch_and_log_unwind<R>(
-    ctxt_msg: &str,
+    ctxt_msg: &'static str,
     f: impl FnOnce() -> R + UnwindSafe,
 ) -> Result<R, ()> {
     fn abort_process_due_to_panic_in_panic_logger() -> ! {
         process::abort()
     }
 
-    fn abort_process_due_to_panic_without_plugin_handle() -> ! {
-        process::abort()
-    }
+    crate::stats::record(ctxt_msg, || {
+        #[cfg(not(feature = "__unstable_single_catch_unwind"))]
+        {
+            catch_unwind(|| match catch_unwind(f) {
+                Ok(x) => Ok(x),
+                Err(e) => {
+                    log_caught_unwind(ctxt_msg, &*e);
+                    Err(())
+                }
+            })
+            .unwrap_or_else(|_| abort_process_due_to_panic_in_panic_logger())
+        }
 
-    catch_unwind(|| match catch_unwind(f) {
-        Ok(x) => Ok(x),
-        Err(e) => {
-            let panic_msg = if let Some(s) = e.downcast_ref::<String>() {
-                s.as_str()
-            } else if let Some(s) = e.downcast_ref::<&'static str>() {
-                s
-            } else {
-                &"<unknown>"
-            };
-
-            eprintln!(
-                "WARNING: `hexavalent` caught panic (in `{}`): {}",
-                ctxt_msg, panic_msg
-            );
+        #[cfg(feature = "__unstable_single_catch_unwind")]
+        {
+            struct AbortOnUnwind;
+
+            impl Drop for AbortOnUnwind {
+                fn drop(&mut self) {
+                    abort_process_due_to_panic_in_panic_logger()
+                }
+            }
 
-            let plugin_handle = LAST_RESORT_PLUGIN_HANDLE.load(Ordering::Relaxed);
-            if plugin_handle.is_null() {
-                eprintln!("FATAL: `hexavalent` cannot find a plugin context");
-                abort_process_due_to_panic_without_plugin_handle()
-            } else {
-                let message = format!(
-                    "WARNING: `hexavalent` caught panic (in `{}`): {}\0",
-                    ctxt_msg, panic_msg
-                );
-                // Safety: message is null-terminated
-                // (Un)Safety: plugin_handle may not be valid, but there's nothing we can do here
-                unsafe { ((*plugin_handle).hexchat_print)(plugin_handle, message.as_ptr().cast()) }
-                Err(())
+            match catch_unwind(f) {
+                Ok(x) => Ok(x),
+                Err(e) => {
+                    // unwinding must not escape into HexChat,
+                    // so the guard aborts if the logger itself panics
+                    let guard = AbortOnUnwind;
+                    log_caught_unwind(ctxt_msg, &*e);
+                    std::mem::forget(guard);
+                    Err(())
+                }
             }
         }
     })
-    .unwrap_or_else(|_| abort_process_due_to_panic_in_panic_logger())
 }
 
 const NO_READERS: usize = 0;
@@ -93,7 +197,14 @@ impl<T> Deref for ExtSync<T> {
 struct GlobalPlugin {
     #[cfg(debug_assertions)]
     thread_id: std::thread::ThreadId,
-    plugin: Box<dyn Any>,
+    /// The user's plugin, type-erased so that `with_plugin_state` can cast it straight back
+    /// to the `P` it was monomorphized for, instead of paying for a `dyn Any` deref
+    /// and downcast on every hook dispatch.
+    plugin: *mut (),
+    /// The type of the plugin behind `plugin`, checked before every cast.
+    plugin_type: TypeId,
+    /// Drops `plugin`; monomorphized for the same `P` by `hexchat_plugin_init`.
+    drop_plugin: unsafe fn(*mut ()),
     plugin_handle: *mut hexchat_plugin,
 }
 
@@ -102,12 +213,136 @@ struct GlobalPlugin {
 /// Only accessible outside this module via the safe interface `with_plugin_state`.
 static PLUGIN: ExtSync<Option<GlobalPlugin>> = ExtSync(UnsafeCell::new(None));
 
+/// Closure hook callbacks registered by the `hook_*_with` functions,
+/// stored in a slab and dispatched by slot index smuggled through `user_data`.
+struct ClosureRegistry {
+    /// One slot per registered closure. `None` slots are free for reuse.
+    slots: Vec<Option<Box<dyn Any>>>,
+    /// Indices of `None` slots in `slots`.
+    free_slots: Vec<usize>,
+    /// Number of closure hook calls currently on the stack.
+    calls_in_progress: usize,
+    /// Closures freed while a call was in progress.
+    ///
+    /// Kept alive until the outermost call returns,
+    /// so that a closure hook can safely unhook itself (or any other closure hook)
+    /// from within its own callback.
+    graveyard: Vec<Box<dyn Any>>,
+}
+
+impl ClosureRegistry {
+    const fn new() -> Self {
+        Self {
+            slots: Vec::new(),
+            free_slots: Vec::new(),
+            calls_in_progress: 0,
+            graveyard: Vec::new(),
+        }
+    }
+
+    fn clear(&mut self) {
+        self.slots.clear();
+        self.free_slots.clear();
+        self.graveyard.clear();
+    }
+}
+
+/// Global registry of closure hook callbacks.
+///
+/// Accessed only through short-lived borrows in `register_closure`, `free_closure`, and `with_closure`,
+/// which never overlap (in particular, no user code runs while the registry is borrowed).
+static CLOSURES: ExtSync<ClosureRegistry> = ExtSync(UnsafeCell::new(ClosureRegistry::new()));
+
+/// Stores a closure hook callback, returning the slot index identifying it.
+pub(crate) fn register_closure(closure: Box<dyn Any>) -> usize {
+    // Safety: this borrow is released before any user code runs
+    let registry = unsafe { &mut *CLOSURES.get() };
+
+    match registry.free_slots.pop() {
+        Some(slot) => {
+            debug_assert!(registry.slots[slot].is_none());
+            registry.slots[slot] = Some(closure);
+            slot
+        }
+        None => {
+            registry.slots.push(Some(closure));
+            registry.slots.len() - 1
+        }
+    }
+}
+
+/// Frees a closure hook callback's slot for reuse.
+///
+/// If any closure hook call is on the stack, the closure itself is kept alive
+/// until the outermost call returns, so that a closure hook can unhook itself.
+///
+/// # Panics
+///
+/// If the slot is already free.
+pub(crate) fn free_closure(slot: usize) {
+    // Safety: this borrow is released before any user code runs
+    let registry = unsafe { &mut *CLOSURES.get() };
+
+    let closure = registry.slots[slot]
+        .take()
+        .unwrap_or_else(|| panic!("Closure hook slot {} is already free", slot));
+    registry.free_slots.push(slot);
+
+    if registry.calls_in_progress > 0 {
+        registry.graveyard.push(closure);
+    }
+}
+
+/// Invokes the closure hook callback stored in `slot`.
+///
+/// # Panics
+///
+/// If the slot is free, or holds a closure of a type other than `F`.
+pub(crate) fn with_closure<F: 'static, R>(slot: usize, f: impl FnOnce(&F) -> R) -> R {
+    let closure: *const F = {
+        // Safety: this borrow is released before any user code runs
+        let registry = unsafe { &mut *CLOSURES.get() };
+
+        let closure = registry
+            .slots
+            .get(slot)
+            .and_then(|slot| slot.as_ref())
+            .unwrap_or_else(|| panic!("Closure hook slot {} is free", slot))
+            .downcast_ref::<F>()
+            .unwrap_or_else(|| panic!("Closure hook slot {} is an unexpected type", slot))
+            as *const F;
+
+        registry.calls_in_progress += 1;
+
+        closure
+    };
+
+    defer! {{
+        // Safety: this borrow is released before any user code runs
+        let registry = unsafe { &mut *CLOSURES.get() };
+        registry.calls_in_progress -= 1;
+        if registry.calls_in_progress == 0 {
+            registry.graveyard.clear();
+        }
+    }}
+
+    // Safety: the registry neither moves nor drops a stored closure while calls are in progress
+    // (freed closures are kept in the graveyard until the outermost call returns),
+    // and the boxed closure's address is stable even if the slab grows
+    f(unsafe { &*closure })
+}
+
 /// Initializes a plugin of type `P`.
 ///
 /// # Safety
 ///
 /// `plugin_handle` must point to a valid `hexchat_plugin`.
 pub(crate) unsafe fn hexchat_plugin_init<P: Plugin>(plugin_handle: *mut hexchat_plugin) -> c_int {
+    unsafe fn drop_plugin<P>(plugin: *mut ()) {
+        // Safety: plugin was created by Box::into_raw in hexchat_plugin_init with the same P
+        drop(Box::from_raw(plugin.cast::<P>()));
+    }
+
     result_to_int(catch_and_log_unwind("init", || {
         LAST_RESORT_PLUGIN_HANDLE.store(plugin_handle, Ordering::Relaxed);
 
@@ -121,12 +356,30 @@ pub(crate) unsafe fn hexchat_plugin_init<P: Plugin>(plugin_handle: *mut hexchat_
             *PLUGIN.get() = Some(GlobalPlugin {
                 #[cfg(debug_assertions)]
                 thread_id: std::thread::current().id(),
-                plugin: Box::new(P::default()),
+                plugin: Box::into_raw(Box::new(P::default())).cast::<()>(),
+                plugin_type: TypeId::of::<P>(),
+                drop_plugin: drop_plugin::<P>,
                 plugin_handle,
             });
+
+            // Safety: STATE guarantees unique access to handles
+            (*CLOSURES.get()).clear();
         }
 
         with_plugin_state(|plugin: &P, ph| plugin.init(ph));
+
+        #[cfg(feature = "__unstable_call_stats")]
+        with_plugin_state(|_plugin: &P, ph| {
+            ph.hook_command(
+                "hexavalent_stats\0",
+                "Usage: HEXAVALENT_STATS, prints hexavalent's per-call-site timing statistics\0",
+                crate::hook::Priority::Normal,
+                |_plugin, ph, _words| {
+                    crate::stats::report(|line| ph.print(line));
+                    crate::hook::Eat::All
+                },
+            );
+        });
     }))
 }
 
@@ -147,7 +400,15 @@ pub(crate) unsafe fn hexchat_plugin_deinit<P: Plugin>(plugin_handle: *mut hexcha
             defer! { STATE.store(NO_READERS, Ordering::Relaxed) };
 
             // Safety: STATE guarantees unique access to handles
-            *PLUGIN.get() = None;
+            if let Some(global_plugin) = (*PLUGIN.get()).take() {
+                // Safety: drop_plugin was monomorphized for the type behind plugin
+                (global_plugin.drop_plugin)(global_plugin.plugin);
+            }
+
+            // Safety: STATE guarantees unique access to handles
+            // (HexChat unhooks all remaining hooks when the plugin unloads,
+            // so their closures can no longer be invoked)
+            (*CLOSURES.get()).clear();
         }
 
         LAST_RESORT_PLUGIN_HANDLE.store(ptr::null_mut(), Ordering::Relaxed);
@@ -164,19 +425,15 @@ pub(crate) unsafe fn hexchat_plugin_deinit<P: Plugin>(plugin_handle: *mut hexcha
 ///
 /// If the initialized plugin is not of type `P`.
 pub(crate) fn with_plugin_state<P: 'static, R>(f: impl FnOnce(&P, PluginHandle<'_, P>) -> R) -> R {
-    // usually this check would be looped to account for multiple reader threads trying to acquire it at the same time
-    // but we expect there to be only one thread, so panic instead
+    // usually this counter would be maintained with compare-exchange loops
+    // to account for multiple reader threads trying to acquire it at the same time,
+    // but we expect there to be only one thread (validated by the thread id check below),
+    // so plain loads and stores suffice, and unexpected states panic instead
     let state = STATE.load(Ordering::Relaxed);
     assert_ne!(state, LOCKED, "plugin invoked while (un)loading");
     assert_ne!(state + 1, LOCKED, "too many references to plugin state");
-    STATE
-        .compare_exchange(state, state + 1, Ordering::Relaxed, Ordering::Relaxed)
-        .unwrap_or_else(|e| panic!("Plugin invoked concurrently (?), state: {}", e));
-    defer! {{
-        STATE
-            .compare_exchange(state + 1, state, Ordering::Relaxed, Ordering::Relaxed)
-            .unwrap_or_else(|e| panic!("Plugin invoked concurrently (?), state: {}", e));
-    }}
+    STATE.store(state + 1, Ordering::Relaxed);
+    defer! { STATE.store(state, Ordering::Relaxed) };
 
     // Safety: STATE guarantees that there are only readers active
     let global_plugin = unsafe {
@@ -192,13 +449,100 @@ pub(crate) fn with_plugin_state<P: 'static, R>(f: impl FnOnce(&P, PluginHandle<'
         "plugin invoked from different thread"
     );
 
-    let plugin = global_plugin
-        .plugin
-        .downcast_ref()
-        .unwrap_or_else(|| panic!("Plugin is an unexpected type"));
+    assert_eq!(
+        global_plugin.plugin_type,
+        TypeId::of::<P>(),
+        "Plugin is an unexpected type"
+    );
+
+    // Safety: the pointer was created from a Box<P> in hexchat_plugin_init
+    // (the type check above proves it is the same P),
+    // and STATE guarantees it is not dropped while readers are active
+    let plugin = unsafe { &*global_plugin.plugin.cast::<P>() };
 
     // Safety: we only store valid `plugin_handle`s in `PLUGIN`
     let ph = unsafe { PluginHandle::new(global_plugin.plugin_handle) };
 
     f(plugin, ph)
 }
+
+#[cfg(test)]
+mod tests {
+    use std::cell::Cell;
+    use std::rc::Rc;
+
+    use super::*;
+
+    // a single test, since the registry is a global and these steps must not interleave
+    #[test]
+    fn closure_registry_lifecycle() {
+        type Callback = Box<dyn Fn() -> usize>;
+
+        let first = register_closure(Box::new(Box::new(|| 1_usize) as Callback));
+        let second = register_closure(Box::new(Box::new(|| 2_usize) as Callback));
+        assert_ne!(first, second);
+
+        assert_eq!(with_closure::<Callback, _>(first, |f| f()), 1);
+        assert_eq!(with_closure::<Callback, _>(second, |f| f()), 2);
+
+        // a closure freed during a call is kept alive until the call returns
+        let dropped = Rc::new(Cell::new(false));
+        let guard = {
+            struct SetOnDrop(Rc<Cell<bool>>);
+            impl Drop for SetOnDrop {
+                fn drop(&mut self) {
+                    self.0.set(true);
+                }
+            }
+            SetOnDrop(Rc::clone(&dropped))
+        };
+        let third = register_closure(Box::new(Box::new(move || {
+            let _ = &guard;
+            3_usize
+        }) as Callback));
+
+        assert_eq!(
+            with_closure::<Callback, _>(third, |f| {
+                free_closure(third);
+                f()
+            }),
+            3_usize
+        );
+        assert!(dropped.get());
+
+        // freed slots are reused
+        let fourth = register_closure(Box::new(Box::new(|| 4_usize) as Callback));
+        assert_eq!(fourth, third);
+
+        free_closure(first);
+        free_closure(second);
+        free_closure(fourth);
+    }
+
+    #[test]
+    fn panic_msg_buffer_formats_and_truncates() {
+        let mut buffer = PanicMsgBuffer::new();
+
+        write!(buffer, "caught panic: {}", 42).unwrap();
+        assert_eq!(&buffer.buf[..buffer.len], b"caught panic: 42");
+
+        buffer.as_c_ptr();
+        assert_eq!(buffer.buf[buffer.len], 0);
+
+        // overflowing writes truncate instead of allocating
+        write!(buffer, "{}", "x".repeat(2 * PanicMsgBuffer::CAPACITY)).unwrap();
+        assert_eq!(buffer.len, PanicMsgBuffer::CAPACITY - 1);
+        buffer.as_c_ptr();
+        assert_eq!(buffer.buf[PanicMsgBuffer::CAPACITY - 1], 0);
+    }
+
+    #[test]
+    fn panic_msg_buffer_truncates_at_char_boundary() {
+        let mut buffer = PanicMsgBuffer::new();
+
+        write!(buffer, "{}", "x".repeat(PanicMsgBuffer::CAPACITY - 2)).unwrap();
+        // 'é' is two bytes, but only one remains
+        write!(buffer, "é").unwrap();
+        assert_eq!(buffer.len, PanicMsgBuffer::CAPACITY - 2);
+    }
+}
@@ -0,0 +1,176 @@
+//! Optional per-call-site timing statistics.
+//!
+//! When the `__unstable_call_stats` feature is enabled, hexavalent times every hook callback
+//! dispatch and the FFI calls on hot [`PluginHandle`](crate::PluginHandle) paths,
+//! recording each duration into a per-call-site histogram.
+//! The histograms can be printed at any time with the built-in `/HEXAVALENT_STATS` command,
+//! which is registered automatically when the plugin loads.
+//!
+//! When the feature is disabled (the default), [`record`] is an `#[inline(always)]`
+//! pass-through and this module contains nothing else, so instrumented call sites
+//! compile to exactly the uninstrumented code.
+
+/// Runs `f`, timing it under the `call_site` histogram if the `__unstable_call_stats`
+/// feature is enabled.
+#[cfg(not(feature = "__unstable_call_stats"))]
+#[inline(always)]
+pub(crate) fn record<R>(_call_site: &'static str, f: impl FnOnce() -> R) -> R {
+    f()
+}
+
+/// Runs `f`, timing it under the `call_site` histogram if the `__unstable_call_stats`
+/// feature is enabled.
+#[cfg(feature = "__unstable_call_stats")]
+pub(crate) fn record<R>(call_site: &'static str, f: impl FnOnce() -> R) -> R {
+    let start = std::time::Instant::now();
+    defer! { enabled::record_duration(call_site, start.elapsed()) };
+    f()
+}
+
+#[cfg(feature = "__unstable_call_stats")]
+pub(crate) use enabled::report;
+
+#[cfg(feature = "__unstable_call_stats")]
+mod enabled {
+    use std::collections::HashMap;
+    use std::convert::TryFrom;
+    use std::fmt::Write;
+    use std::sync::Mutex;
+    use std::time::Duration;
+
+    /// A log2-bucketed histogram of call durations, in nanoseconds.
+    ///
+    /// Bucket `i` counts durations where `duration_ns.log2() == i`,
+    /// i.e. durations from `2^i` up to (but excluding) `2^(i + 1)` nanoseconds.
+    struct Histogram {
+        buckets: [u64; 64],
+        count: u64,
+        total: Duration,
+    }
+
+    impl Default for Histogram {
+        fn default() -> Self {
+            Self {
+                buckets: [0; 64],
+                count: 0,
+                total: Duration::from_secs(0),
+            }
+        }
+    }
+
+    impl Histogram {
+        fn add(&mut self, duration: Duration) {
+            let nanos = u64::try_from(duration.as_nanos()).unwrap_or(u64::MAX);
+            let bucket = 63_u32.saturating_sub(nanos.leading_zeros());
+            self.buckets[bucket as usize] += 1;
+            self.count += 1;
+            self.total += duration;
+        }
+
+        /// The upper bound of the bucket containing the `q`th quantile, in nanoseconds.
+        fn quantile_upper_bound(&self, q: f64) -> u64 {
+            let rank = (self.count as f64 * q).ceil() as u64;
+            let mut seen = 0;
+            for (bucket, &count) in self.buckets.iter().enumerate() {
+                seen += count;
+                if seen >= rank.max(1) {
+                    return 2_u64.saturating_pow(bucket as u32 + 1);
+                }
+            }
+            0
+        }
+    }
+
+    /// Map from call site to its histogram.
+    ///
+    /// Keyed by the address of the `&'static str` passed to `record`,
+    /// so steady-state recording does not hash string contents.
+    static STATS: Mutex<Option<HashMap<usize, (&'static str, Histogram)>>> = Mutex::new(None);
+
+    pub(crate) fn record_duration(call_site: &'static str, duration: Duration) {
+        let mut stats = STATS.lock().unwrap_or_else(|e| e.into_inner());
+        stats
+            .get_or_insert_with(HashMap::new)
+            .entry(call_site.as_ptr() as usize)
+            .or_insert_with(|| (call_site, Histogram::default()))
+            .1
+            .add(duration);
+    }
+
+    /// Formats one line per recorded call site, sorted by total time descending,
+    /// and passes each to `emit`.
+    pub(crate) fn report(mut emit: impl FnMut(&str)) {
+        let mut entries: Vec<(&'static str, u64, Duration, u64, u64)> = {
+            let stats = STATS.lock().unwrap_or_else(|e| e.into_inner());
+            stats
+                .iter()
+                .flatten()
+                .map(|(_, (call_site, histogram))| {
+                    (
+                        *call_site,
+                        histogram.count,
+                        histogram.total,
+                        histogram.quantile_upper_bound(0.5),
+                        histogram.quantile_upper_bound(0.99),
+                    )
+                })
+                .collect()
+        };
+
+        if entries.is_empty() {
+            emit("hexavalent stats: no calls recorded");
+            return;
+        }
+
+        entries.sort_by(|a, b| b.2.cmp(&a.2));
+
+        let mut line = String::new();
+        for (call_site, count, total, p50, p99) in entries {
+            line.clear();
+            write!(
+                line,
+                "hexavalent stats: {}: count {}, total {:?}, p50 < {:?}, p99 < {:?}",
+                call_site,
+                count,
+                total,
+                Duration::from_nanos(p50),
+                Duration::from_nanos(p99),
+            )
+            .unwrap();
+            emit(&line);
+        }
+    }
+
+    #[cfg(test)]
+    mod tests {
+        use super::*;
+
+        #[test]
+        fn histogram_buckets_by_log2() {
+            let mut histogram = Histogram::default();
+            for &nanos in &[1, 2, 3, 1000, 1024, u64::MAX] {
+                histogram.add(Duration::from_nanos(nanos));
+            }
+
+            assert_eq!(histogram.buckets[0], 1); // 1ns
+            assert_eq!(histogram.buckets[1], 2); // 2ns, 3ns
+            assert_eq!(histogram.buckets[9], 1); // 1000ns
+            assert_eq!(histogram.buckets[10], 1); // 1024ns
+            assert_eq!(histogram.buckets[63], 1); // u64::MAX ns
+            assert_eq!(histogram.count, 6);
+        }
+
+        #[test]
+        fn quantiles_come_from_buckets() {
+            let mut histogram = Histogram::default();
+            for _ in 0..99 {
+                histogram.add(Duration::from_nanos(100)); // bucket 6
+            }
+            histogram.add(Duration::from_nanos(1_000_000)); // bucket 19
+
+            assert_eq!(histogram.quantile_upper_bound(0.5), 128);
+            assert_eq!(histogram.quantile_upper_bound(0.99), 128);
+            assert_eq!(histogram.quantile_upper_bound(1.0), 1 << 20);
+        }
+    }
+}
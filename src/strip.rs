@@ -1,5 +1,7 @@
 //! String format stripping.
 
+use std::borrow::Cow;
+
 /// Whether to strip mIRC color attributes.
 ///
 /// Used with [`PluginHandle::strip`](crate::PluginHandle::strip).
@@ -23,3 +25,164 @@ pub enum TextAttrs {
     /// Strip text attributes.
     Remove,
 }
+
+const ATTR_BOLD: char = '\x02';
+const ATTR_COLOR: char = '\x03';
+const ATTR_BEEP: char = '\x07';
+const ATTR_RESET: char = '\x0f';
+const ATTR_REVERSE: char = '\x16';
+const ATTR_ITALICS: char = '\x1d';
+const ATTR_UNDERLINE: char = '\x1f';
+
+/// Strips mIRC colors and/or text attributes (bold, underline, etc.) from a string.
+///
+/// Behaves the same as [`PluginHandle::strip`](crate::PluginHandle::strip),
+/// but runs entirely in Rust, with no FFI call;
+/// when the input contains no formatting (the common case for incoming messages),
+/// the input is returned as [`Cow::Borrowed`] and nothing is allocated or copied.
+///
+/// # Examples
+///
+/// ```rust
+/// use std::borrow::Cow;
+/// use hexavalent::strip::{strip, MircColors, TextAttrs};
+///
+/// let orig = "\x0312Blue\x03 \x02Bold!\x02";
+///
+/// let strip_all = strip(orig, MircColors::Remove, TextAttrs::Remove);
+/// assert_eq!(strip_all, "Blue Bold!");
+///
+/// let strip_colors = strip(orig, MircColors::Remove, TextAttrs::Keep);
+/// assert_eq!(strip_colors, "Blue \x02Bold!\x02");
+///
+/// let unformatted = strip("just plain text", MircColors::Remove, TextAttrs::Remove);
+/// assert!(matches!(unformatted, Cow::Borrowed(_)));
+/// ```
+pub fn strip(str: &str, mirc: MircColors, attrs: TextAttrs) -> Cow<'_, str> {
+    let strip_color = matches!(mirc, MircColors::Remove);
+    let strip_attr = matches!(attrs, TextAttrs::Remove);
+
+    // hidden-text markers (`\x08`) are not stripped: HexChat only removes them
+    // under `STRIP_HIDDEN`, which `PluginHandle::strip` does not pass
+    let is_stripped_char = |c: char| match c {
+        ATTR_COLOR => strip_color,
+        ATTR_BOLD | ATTR_BEEP | ATTR_RESET | ATTR_REVERSE | ATTR_ITALICS | ATTR_UNDERLINE => {
+            strip_attr
+        }
+        _ => false,
+    };
+
+    // find the first formatting char up front to avoid copying the string if there is nothing to strip
+    let unformatted_len = match str.find(is_stripped_char) {
+        Some(index) => index,
+        None => return Cow::Borrowed(str),
+    };
+
+    let mut stripped = String::with_capacity(str.len());
+    stripped.push_str(&str[..unformatted_len]);
+
+    // the following replicates HexChat's `strip_color2`:
+    // a color char is followed by up to two foreground digits,
+    // optionally followed by a comma and up to two background digits
+    let mut remaining_color_digits = 0;
+    let mut in_background_color = false;
+
+    let mut chars = str[unformatted_len..].chars().peekable();
+    while let Some(c) = chars.next() {
+        let next_is_digit = matches!(chars.peek(), Some(n) if n.is_ascii_digit());
+        if remaining_color_digits > 0
+            && (c.is_ascii_digit() || (c == ',' && next_is_digit && !in_background_color))
+        {
+            if chars.peek() != Some(&',') {
+                remaining_color_digits -= 1;
+            }
+            if c == ',' {
+                remaining_color_digits = 2;
+                in_background_color = true;
+            }
+        } else {
+            remaining_color_digits = 0;
+            in_background_color = false;
+            if c == ATTR_COLOR && strip_color {
+                remaining_color_digits = 2;
+            } else if !is_stripped_char(c) {
+                stripped.push(c);
+            }
+        }
+    }
+
+    Cow::Owned(stripped)
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    fn strip_all(str: &str) -> Cow<'_, str> {
+        strip(str, MircColors::Remove, TextAttrs::Remove)
+    }
+
+    #[test]
+    fn strip_borrows_unformatted_input() {
+        assert!(matches!(strip_all("hello world"), Cow::Borrowed(_)));
+        assert!(matches!(
+            strip("\x02bold\x02", MircColors::Remove, TextAttrs::Keep),
+            Cow::Borrowed(_)
+        ));
+        assert!(matches!(
+            strip("\x0304red", MircColors::Keep, TextAttrs::Remove),
+            Cow::Borrowed(_)
+        ));
+    }
+
+    #[test]
+    fn strip_removes_attrs() {
+        assert_eq!(
+            strip_all("\x02bold\x02 \x1funder\x1f \x1ditalics\x1d"),
+            "bold under italics"
+        );
+        assert_eq!(
+            strip_all("\x0freset \x16reverse \x07beep"),
+            "reset reverse beep"
+        );
+    }
+
+    #[test]
+    fn strip_keeps_hidden_text_markers() {
+        // `PluginHandle::strip` does not pass `STRIP_HIDDEN`, so neither does this
+        assert_eq!(
+            strip_all("\x08hidden\x08 \x02bold\x02"),
+            "\x08hidden\x08 bold"
+        );
+        assert!(matches!(strip_all("\x08hidden\x08"), Cow::Borrowed(_)));
+    }
+
+    #[test]
+    fn strip_removes_colors() {
+        assert_eq!(strip_all("\x034red\x03 text"), "red text");
+        assert_eq!(strip_all("\x0304red"), "red");
+        assert_eq!(strip_all("\x0312,04colored"), "colored");
+        // at most two digits belong to the color code
+        assert_eq!(strip_all("\x03123"), "3");
+        assert_eq!(strip_all("\x0312,345"), "5");
+    }
+
+    #[test]
+    fn strip_keeps_colors_when_asked() {
+        assert_eq!(
+            strip(
+                "\x0312Blue\x03 \x02Bold\x02",
+                MircColors::Keep,
+                TextAttrs::Remove
+            ),
+            "\x0312Blue\x03 Bold"
+        );
+    }
+
+    #[test]
+    fn strip_color_digits_without_color_char_are_kept() {
+        assert_eq!(strip_all("1,2 untouched"), Cow::Borrowed("1,2 untouched"));
+        // a comma with no digit following ends the color code
+        assert_eq!(strip_all("\x034,x"), ",x");
+    }
+}
@@ -0,0 +1,414 @@
+//! Timer task scheduling.
+
+use std::cell::RefCell;
+use std::cmp::Ordering;
+use std::collections::{BinaryHeap, HashSet};
+use std::fmt;
+use std::time::{Duration, Instant};
+
+use crate::hook::{HookHandle, Timer};
+use crate::plugin::PluginHandle;
+
+/// A handle to a task scheduled with a [`Timers`] scheduler.
+///
+/// Cannot be constructed in user code, but is returned from
+/// [`Timers::schedule_once`] and [`Timers::schedule_repeating`].
+///
+/// Can be passed to [`Timers::cancel`] to cancel the task.
+#[derive(Debug)]
+pub struct TaskHandle {
+    id: u64,
+}
+
+/// The work performed by a scheduled task.
+enum Task<P> {
+    /// Runs once, at the entry's deadline.
+    Once(Box<dyn FnOnce(&P, PluginHandle<'_, P>)>),
+    /// Runs at the entry's deadline, then again every `interval`.
+    Repeating {
+        interval: Duration,
+        callback: Box<dyn Fn(&P, PluginHandle<'_, P>)>,
+    },
+}
+
+/// A scheduled task, ordered by deadline (earliest first).
+struct Entry<P> {
+    deadline: Instant,
+    id: u64,
+    task: Task<P>,
+}
+
+impl<P> PartialEq for Entry<P> {
+    fn eq(&self, other: &Self) -> bool {
+        self.id == other.id
+    }
+}
+
+impl<P> Eq for Entry<P> {}
+
+impl<P> PartialOrd for Entry<P> {
+    fn partial_cmp(&self, other: &Self) -> Option<Ordering> {
+        Some(self.cmp(other))
+    }
+}
+
+impl<P> Ord for Entry<P> {
+    fn cmp(&self, other: &Self) -> Ordering {
+        // reversed, so that `BinaryHeap` (a max-heap) yields the earliest deadline first
+        other
+            .deadline
+            .cmp(&self.deadline)
+            .then(other.id.cmp(&self.id))
+    }
+}
+
+struct TimersInner<P> {
+    /// Scheduled tasks, earliest deadline first.
+    queue: BinaryHeap<Entry<P>>,
+    /// The id assigned to the next scheduled task.
+    next_id: u64,
+    /// Ids of cancelled tasks whose entries are still live.
+    cancelled: HashSet<u64>,
+    /// The id of the task whose callback is currently running, if any.
+    ///
+    /// The running task's entry is popped from `queue` before its callback runs,
+    /// but it is still live (a task may cancel itself), so `cancel` must treat it as such.
+    running: Option<u64>,
+}
+
+impl<P> TimersInner<P> {
+    /// Removes and returns the earliest entry due at `now`, skipping cancelled entries.
+    fn pop_due(&mut self, now: Instant) -> Option<Entry<P>> {
+        loop {
+            match self.queue.peek() {
+                Some(entry) if entry.deadline <= now => {}
+                _ => return None,
+            }
+            let entry = self
+                .queue
+                .pop()
+                .unwrap_or_else(|| panic!("Peeked timer entry disappeared, should be infallible"));
+            if !self.cancelled.remove(&entry.id) {
+                return Some(entry);
+            }
+        }
+    }
+}
+
+/// Advances a repeating task's deadline past `now`, skipping missed intervals.
+///
+/// If ticks were delayed (e.g. the UI thread was blocked), the task runs once and
+/// resumes its normal cadence, instead of running repeatedly to "catch up".
+fn next_deadline(mut deadline: Instant, interval: Duration, now: Instant) -> Instant {
+    while deadline <= now {
+        deadline += interval;
+    }
+    deadline
+}
+
+/// A scheduler multiplexing many timer tasks onto one HexChat timer.
+///
+/// Each [`PluginHandle::hook_timer`](crate::PluginHandle::hook_timer) call registers
+/// a separate timer with HexChat, and every tick of every timer crosses the FFI boundary
+/// and passes through panic-catching and plugin state bookkeeping separately.
+/// A `Timers` scheduler instead keeps Rust-side deadlines in a binary heap
+/// driven by a single HexChat timer, so a plugin running dozens of periodic jobs
+/// costs one FFI timer registration, and a tick where nothing is due is a single heap peek.
+///
+/// Unlike the `hook_timer` family, scheduled tasks are closures and can capture variables.
+///
+/// To use it, store a `Timers` in your plugin, implement `AsRef<Timers<Self>>`,
+/// and call [`PluginHandle::hook_timers`] in [`Plugin::init`](crate::Plugin::init).
+/// See [`PluginHandle::hook_timers`] for an example.
+pub struct Timers<P> {
+    inner: RefCell<TimersInner<P>>,
+}
+
+impl<P> fmt::Debug for Timers<P> {
+    fn fmt(&self, f: &mut fmt::Formatter<'_>) -> fmt::Result {
+        let inner = self.inner.borrow();
+        let tasks = inner
+            .queue
+            .iter()
+            .filter(|entry| !inner.cancelled.contains(&entry.id))
+            .count();
+        f.debug_struct("Timers").field("tasks", &tasks).finish()
+    }
+}
+
+impl<P> Default for Timers<P> {
+    fn default() -> Self {
+        Self::new()
+    }
+}
+
+impl<P> Timers<P> {
+    /// Creates a new, empty `Timers` scheduler.
+    pub fn new() -> Self {
+        Self {
+            inner: RefCell::new(TimersInner {
+                queue: BinaryHeap::new(),
+                next_id: 0,
+                cancelled: HashSet::new(),
+                running: None,
+            }),
+        }
+    }
+
+    /// Schedules a task to run once, after `delay`.
+    ///
+    /// The task runs on the first scheduler tick at or after its deadline,
+    /// so its accuracy is limited by the `resolution` passed to [`PluginHandle::hook_timers`].
+    ///
+    /// Returns a [`TaskHandle`] which can be passed to [`Timers::cancel`] to cancel the task.
+    pub fn schedule_once(
+        &self,
+        delay: Duration,
+        callback: impl FnOnce(&P, PluginHandle<'_, P>) + 'static,
+    ) -> TaskHandle {
+        self.schedule(delay, Task::Once(Box::new(callback)))
+    }
+
+    /// Schedules a task to run every `interval`, starting one `interval` from now.
+    ///
+    /// The task runs on the first scheduler tick at or after each deadline,
+    /// so its accuracy is limited by the `resolution` passed to [`PluginHandle::hook_timers`].
+    /// If ticks are delayed past several deadlines, the task runs once, not once per missed deadline.
+    ///
+    /// Returns a [`TaskHandle`] which can be passed to [`Timers::cancel`] to cancel the task.
+    pub fn schedule_repeating(
+        &self,
+        interval: Duration,
+        callback: impl Fn(&P, PluginHandle<'_, P>) + 'static,
+    ) -> TaskHandle {
+        self.schedule(
+            interval,
+            Task::Repeating {
+                interval,
+                callback: Box::new(callback),
+            },
+        )
+    }
+
+    fn schedule(&self, delay: Duration, task: Task<P>) -> TaskHandle {
+        let mut inner = self.inner.borrow_mut();
+
+        let id = inner.next_id;
+        inner.next_id += 1;
+
+        inner.queue.push(Entry {
+            deadline: Instant::now() + delay,
+            id,
+            task,
+        });
+
+        TaskHandle { id }
+    }
+
+    /// Cancels a scheduled task.
+    ///
+    /// The task will not run again; it is safe for a task to cancel itself.
+    /// Its closure is dropped when its deadline next comes up, not immediately.
+    pub fn cancel(&self, task: TaskHandle) {
+        let mut inner = self.inner.borrow_mut();
+        // only ids with a live entry enter `cancelled`: the id of a task which already
+        // completed would otherwise linger (and skew the live-task count) forever
+        if inner.running == Some(task.id) || inner.queue.iter().any(|entry| entry.id == task.id) {
+            inner.cancelled.insert(task.id);
+        }
+    }
+
+    /// Cancels all scheduled tasks and drops their closures.
+    pub fn clear(&self) {
+        let mut inner = self.inner.borrow_mut();
+        inner.queue.clear();
+        inner.cancelled.clear();
+    }
+
+    /// Runs every task due at this instant.
+    fn tick(&self, plugin: &P, ph: PluginHandle<'_, P>) {
+        let now = Instant::now();
+        // entries are popped before their callbacks run (and the borrow is released),
+        // so a task can schedule or cancel other tasks without re-entering the borrow
+        loop {
+            let entry = {
+                let mut inner = self.inner.borrow_mut();
+                match inner.pop_due(now) {
+                    Some(entry) => {
+                        inner.running = Some(entry.id);
+                        entry
+                    }
+                    None => break,
+                }
+            };
+            match entry.task {
+                Task::Once(callback) => {
+                    callback(plugin, ph);
+
+                    let mut inner = self.inner.borrow_mut();
+                    inner.running = None;
+                    // the callback may have cancelled its own (now completed) task
+                    inner.cancelled.remove(&entry.id);
+                }
+                Task::Repeating { interval, callback } => {
+                    callback(plugin, ph);
+
+                    let mut inner = self.inner.borrow_mut();
+                    inner.running = None;
+                    // the callback may have cancelled its own task
+                    if !inner.cancelled.remove(&entry.id) {
+                        inner.queue.push(Entry {
+                            deadline: next_deadline(entry.deadline, interval, now),
+                            id: entry.id,
+                            task: Task::Repeating { interval, callback },
+                        });
+                    }
+                }
+            }
+        }
+    }
+}
+
+/// [Timer Task Scheduling](crate::timer::Timers)
+///
+/// Allows your plugin to multiplex many timer tasks onto one HexChat timer.
+impl<'ph, P: 'static + AsRef<Timers<P>>> PluginHandle<'ph, P> {
+    /// Registers the single HexChat timer driving your plugin's [`Timers`] scheduler.
+    ///
+    /// `resolution` is the underlying timer's interval: tasks never run earlier than scheduled,
+    /// but can run up to one `resolution` late.
+    ///
+    /// Call this once from [`Plugin::init`](crate::Plugin::init).
+    ///
+    /// Returns a [`HookHandle`](crate::hook::HookHandle) which can be passed to
+    /// [`PluginHandle::unhook`](crate::PluginHandle::unhook) to stop the scheduler entirely.
+    ///
+    /// # Examples
+    ///
+    /// ```rust
+    /// use std::time::Duration;
+    /// use hexavalent::{Plugin, PluginHandle};
+    /// use hexavalent::timer::Timers;
+    ///
+    /// #[derive(Default)]
+    /// struct MyPlugin {
+    ///     timers: Timers<Self>,
+    /// }
+    ///
+    /// impl AsRef<Timers<MyPlugin>> for MyPlugin {
+    ///     fn as_ref(&self) -> &Timers<MyPlugin> {
+    ///         &self.timers
+    ///     }
+    /// }
+    ///
+    /// impl Plugin for MyPlugin {
+    ///     fn init(&self, ph: PluginHandle<'_, Self>) {
+    ///         ph.hook_timers(Duration::from_millis(100));
+    ///
+    ///         self.timers.schedule_once(Duration::from_secs(5), |plugin, ph| {
+    ///             ph.print("Five seconds since load.\0");
+    ///         });
+    ///         let flood_check = self.timers.schedule_repeating(Duration::from_secs(1), |plugin, ph| {
+    ///             // per-channel flood counters, cache expiry, etc.
+    ///         });
+    ///     }
+    /// }
+    /// ```
+    pub fn hook_timers(self, resolution: Duration) -> HookHandle {
+        self.hook_timer(resolution, |plugin, ph| {
+            plugin.as_ref().tick(plugin, ph);
+            Timer::Continue
+        })
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    type TestTimers = Timers<()>;
+
+    fn deadlines_due(timers: &TestTimers, now: Instant) -> Vec<u64> {
+        let mut inner = timers.inner.borrow_mut();
+        let mut ids = Vec::new();
+        while let Some(entry) = inner.pop_due(now) {
+            ids.push(entry.id);
+        }
+        ids
+    }
+
+    #[test]
+    fn tasks_are_due_earliest_first() {
+        let timers = TestTimers::new();
+        let _late = timers.schedule_once(Duration::from_secs(20), |_, _| {});
+        let early = timers.schedule_once(Duration::from_secs(0), |_, _| {});
+        let middle = timers.schedule_once(Duration::from_secs(10), |_, _| {});
+
+        let now = Instant::now() + Duration::from_secs(15);
+        assert_eq!(deadlines_due(&timers, now), [early.id, middle.id]);
+        assert_eq!(deadlines_due(&timers, now), []);
+    }
+
+    #[test]
+    fn cancelled_tasks_are_skipped() {
+        let timers = TestTimers::new();
+        let first = timers.schedule_once(Duration::from_secs(0), |_, _| {});
+        let second = timers.schedule_once(Duration::from_secs(1), |_, _| {});
+        timers.cancel(first);
+
+        let now = Instant::now() + Duration::from_secs(5);
+        assert_eq!(deadlines_due(&timers, now), [second.id]);
+        assert!(timers.inner.borrow().cancelled.is_empty());
+    }
+
+    #[test]
+    fn cancelling_completed_task_is_inert() {
+        let timers = TestTimers::new();
+        let task = timers.schedule_once(Duration::from_secs(0), |_, _| {});
+
+        let now = Instant::now() + Duration::from_secs(1);
+        assert_eq!(deadlines_due(&timers, now), [task.id]);
+
+        // the task already ran, so cancelling it must not leave a stale id behind
+        timers.cancel(task);
+        assert!(timers.inner.borrow().cancelled.is_empty());
+        assert_eq!(format!("{:?}", timers), "Timers { tasks: 0 }");
+    }
+
+    #[test]
+    fn cancelling_running_task_is_respected() {
+        let timers = TestTimers::new();
+        let task = timers.schedule_repeating(Duration::from_secs(1), |_, _| {});
+
+        // simulate the task's own callback running: its entry is popped, but still live
+        {
+            let mut inner = timers.inner.borrow_mut();
+            let entry = inner
+                .pop_due(Instant::now() + Duration::from_secs(2))
+                .unwrap();
+            inner.running = Some(entry.id);
+        }
+        timers.cancel(task);
+        assert!(!timers.inner.borrow().cancelled.is_empty());
+    }
+
+    #[test]
+    fn debug_counts_live_tasks() {
+        let timers = TestTimers::new();
+        let first = timers.schedule_once(Duration::from_secs(10), |_, _| {});
+        let _second = timers.schedule_once(Duration::from_secs(10), |_, _| {});
+
+        timers.cancel(first);
+        assert_eq!(format!("{:?}", timers), "Timers { tasks: 1 }");
+    }
+
+    #[test]
+    fn missed_intervals_are_skipped() {
+        let start = Instant::now();
+        let interval = Duration::from_secs(1);
+        let now = start + Duration::from_millis(3500);
+
+        let deadline = next_deadline(start, interval, now);
+        assert_eq!(deadline, start + Duration::from_secs(4));
+    }
+}